@@ -280,11 +280,12 @@ using TaskPtr = std::shared_ptr<Task<InType, OutType>>;
 /// @brief Constructs and returns a shared pointer to a task with the given input.
 /// @tparam TaskType Type of the task to create.
 /// @tparam InType Type of the input.
-/// @param in Input to pass to the task constructor.
+/// @param in Input to pass to the task constructor; it is moved on, so task constructors taking InType by value
+///           can adopt the buffers without copying them.
 /// @return Shared a pointer to the newly created task.
 template <typename TaskType, typename InType>
-std::shared_ptr<TaskType> TaskGetter(const InType &in) {
-  return std::make_shared<TaskType>(in);
+std::shared_ptr<TaskType> TaskGetter(InType in) {
+  return std::make_shared<TaskType>(std::move(in));
 }
 
 }  // namespace ppc::task
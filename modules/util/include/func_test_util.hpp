@@ -56,7 +56,7 @@ class BaseRunFuncTests : public ::testing::TestWithParam<FuncTestParam<InType, O
   }
 
  protected:
-  void ExecuteTest(FuncTestParam<InType, OutType, TestType> test_param) {
+  void ExecuteTest(const FuncTestParam<InType, OutType, TestType> &test_param) {
     const std::string &test_name = std::get<static_cast<std::size_t>(GTestParamIndex::kNameTest)>(test_param);
 
     ValidateTestName(test_name);
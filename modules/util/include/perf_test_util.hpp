@@ -68,8 +68,8 @@ class BaseRunPerfTests : public ::testing::TestWithParam<PerfTestParam<InType, O
   }
 
   void ExecuteTest(const PerfTestParam<InType, OutType> &perf_test_param) {
-    auto task_getter = std::get<static_cast<std::size_t>(GTestParamIndex::kTaskGetter)>(perf_test_param);
-    auto test_name = std::get<static_cast<std::size_t>(GTestParamIndex::kNameTest)>(perf_test_param);
+    const auto &task_getter = std::get<static_cast<std::size_t>(GTestParamIndex::kTaskGetter)>(perf_test_param);
+    const auto &test_name = std::get<static_cast<std::size_t>(GTestParamIndex::kNameTest)>(perf_test_param);
     auto mode = std::get<static_cast<std::size_t>(GTestParamIndex::kTestParams)>(perf_test_param);
 
     ASSERT_FALSE(test_name.find("unknown") != std::string::npos);
@@ -98,7 +98,7 @@ class BaseRunPerfTests : public ::testing::TestWithParam<PerfTestParam<InType, O
       perf.PrintPerfStatistic(test_name);
     }
 
-    OutType output_data = task_->GetOutput();
+    OutType &output_data = task_->GetOutput();
     ASSERT_TRUE(CheckTestOutputData(output_data));
   }
 
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <mpi.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "rychkova_d_sobel_edge_detection/common/include/common.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_workspace.hpp"
+#include "rychkova_d_sobel_edge_detection/mpi/include/ops_mpi.hpp"
+#include "task/include/task.hpp"
+
+namespace rychkova_d_sobel_edge_detection {
+
+class SobelEdgeDetectionALL : public BaseTask {
+ public:
+  static constexpr ppc::task::TypeOfTask GetStaticTypeOfTask() {
+    return ppc::task::TypeOfTask::kALL;
+  }
+
+  explicit SobelEdgeDetectionALL(InType in, SobelOptions options = {});
+  SobelEdgeDetectionALL(const SobelEdgeDetectionALL &) = delete;
+  SobelEdgeDetectionALL &operator=(const SobelEdgeDetectionALL &) = delete;
+  SobelEdgeDetectionALL(SobelEdgeDetectionALL &&) = delete;
+  SobelEdgeDetectionALL &operator=(SobelEdgeDetectionALL &&) = delete;
+  ~SobelEdgeDetectionALL() override;
+
+ private:
+  bool ValidationImpl() override;
+  bool PreProcessingImpl() override;
+  bool RunImpl() override;
+  bool PostProcessingImpl() override;
+
+  // Image size, broadcast in PreProcessing, and the gray row datatype the collectives count in; the type is kept
+  // from run to run and rebuilt only when the width changes.
+  std::size_t width_ = 0;
+  std::size_t height_ = 0;
+  MPI_Datatype row_type_ = MPI_DATATYPE_NULL;
+  std::size_t row_type_width_ = 0;
+  // Rank 0 holds the gray frame and the output in the workspace; every rank keeps its strip and the counts, all
+  // planned in PreProcessing.
+  SobelWorkspace workspace_;
+  RowStrip strip_;
+  PixelBuffer<uint8_t> gray_chunk_;
+  PixelBuffer<uint8_t> local_out_;
+  std::vector<int> sendcounts_;
+  std::vector<int> displs_;
+  std::vector<int> recvcounts_out_;
+  std::vector<int> displs_out_;
+  SobelOptions options_;
+};
+
+}  // namespace rychkova_d_sobel_edge_detection
@@ -0,0 +1,245 @@
+#include "rychkova_d_sobel_edge_detection/all/include/ops_all.hpp"
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+#include "rychkova_d_sobel_edge_detection/common/include/common.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_gray.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_kernel.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_pixel.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_stencil.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_tiles.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_workspace.hpp"
+#include "rychkova_d_sobel_edge_detection/mpi/include/ops_mpi.hpp"
+#include "util/include/util.hpp"
+
+namespace rychkova_d_sobel_edge_detection {
+
+SobelEdgeDetectionALL::SobelEdgeDetectionALL(InType in, SobelOptions options) : options_(options) {
+  SetTypeOfTask(GetStaticTypeOfTask());
+  GetInput() = std::move(in);
+  GetOutput() = OutType{};
+}
+
+SobelEdgeDetectionALL::~SobelEdgeDetectionALL() {
+  int finalized = 0;
+  MPI_Finalized(&finalized);
+  if (finalized == 0 && row_type_ != MPI_DATATYPE_NULL) {
+    MPI_Type_free(&row_type_);
+  }
+}
+
+bool SobelEdgeDetectionALL::ValidationImpl() {
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  // Every rank holds the same options, so every rank rejects a bad combination and none enters PreProcessing alone.
+  if (!ValidTiling(options_)) {
+    return false;
+  }
+  if (rank != 0) {
+    return true;
+  }
+
+  const auto &in = GetInput();
+  if (in.width == 0 || in.height == 0) {
+    return false;
+  }
+  if (!ValidPixelFormat(in.channels, in.layout)) {
+    return false;
+  }
+
+  if (!ValidImageBuffer(in)) {
+    return false;
+  }
+  // MPI counts are expressed in gray rows, so a row and the number of rows must fit into an int.
+  constexpr auto kMaxCount = static_cast<std::size_t>(std::numeric_limits<int>::max());
+  if (in.width > kMaxCount || in.height > kMaxCount) {
+    return false;
+  }
+
+  const auto &out = GetOutput();
+  return out.data.empty() && out.width == 0 && out.height == 0;
+}
+
+bool SobelEdgeDetectionALL::PreProcessingImpl() {
+  int rank = 0;
+  int size = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+  if (rank == 0) {
+    const auto &in = GetInput();
+    auto &out = GetOutput();
+    out.width = in.width;
+    out.height = in.height;
+    out.channels = 1;
+    workspace_.PrepareOut(out.data, in.width, in.height, StencilRadius(options_.stencil));
+
+    const std::size_t pixels = in.width * in.height;
+    uint8_t *dst = workspace_.PrepareGray(pixels);
+    const std::size_t chunks = (pixels + kGrayChunkPixels - 1) / kGrayChunkPixels;
+
+#pragma omp parallel for default(none) shared(in, dst, pixels, chunks) schedule(static) \
+    num_threads(ppc::util::GetNumThreads())
+    for (std::size_t k = 0; k < chunks; ++k) {
+      GrayPixels(in, dst, k * kGrayChunkPixels, std::min(pixels, (k + 1) * kGrayChunkPixels));
+    }
+  }
+
+  std::array<std::size_t, 2> dims = {GetInput().width, GetInput().height};
+  MPI_Bcast(dims.data(), 2, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+  width_ = dims[0];
+  height_ = dims[1];
+
+  // Counts and displacements are in rows, which keeps them within int range for frames above 2 GiB.
+  if (row_type_width_ != width_) {
+    if (row_type_ != MPI_DATATYPE_NULL) {
+      MPI_Type_free(&row_type_);
+    }
+    MPI_Type_contiguous(static_cast<int>(width_), MPI_UNSIGNED_CHAR, &row_type_);
+    MPI_Type_commit(&row_type_);
+    row_type_width_ = width_;
+  }
+
+  // Strips, their halos and the root's counts depend on the geometry only, so Run just moves and filters rows. The
+  // buffers and counts are members that keep their capacity, so repeated runs do not allocate.
+  const std::size_t radius = StencilRadius(options_.stencil);
+  if (width_ <= 2 * radius || height_ <= 2 * radius) {
+    return true;
+  }
+  const auto nranks = static_cast<std::size_t>(size);
+  strip_ = StripOf(static_cast<std::size_t>(rank), nranks, height_, radius);
+  gray_chunk_.resize(strip_.RecvRows() * width_);
+  local_out_.resize(strip_.rows * width_);
+  if (rank == 0) {
+    sendcounts_.resize(nranks);
+    displs_.resize(nranks);
+    recvcounts_out_.resize(nranks);
+    displs_out_.resize(nranks);
+    for (std::size_t r = 0; r < nranks; ++r) {
+      const RowStrip other = StripOf(r, nranks, height_, radius);
+      sendcounts_[r] = static_cast<int>(other.RecvRows());
+      displs_[r] = static_cast<int>(other.start - other.halo_top);
+      recvcounts_out_[r] = static_cast<int>(other.rows);
+      displs_out_[r] = static_cast<int>(other.start);
+    }
+  }
+  return true;
+}
+
+bool SobelEdgeDetectionALL::RunImpl() {
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  const std::size_t w = width_;
+  const std::size_t h = height_;
+
+  if (w == 0 || h == 0) {
+    return false;
+  }
+
+  const std::size_t radius = StencilRadius(options_.stencil);
+  if (w <= 2 * radius || h <= 2 * radius) {
+    if (rank == 0) {
+      std::fill(workspace_.out.begin(), workspace_.out.end(), 0);
+    }
+    return true;
+  }
+
+  const std::size_t local_rows = strip_.rows;
+  const std::size_t start_row = strip_.start;
+  const std::size_t halo_top = strip_.halo_top;
+
+  MPI_Scatterv(rank == 0 ? workspace_.gray.data() : nullptr, rank == 0 ? sendcounts_.data() : nullptr,
+               rank == 0 ? displs_.data() : nullptr, row_type_, gray_chunk_.data(),
+               static_cast<int>(strip_.RecvRows()), row_type_, 0, MPI_COMM_WORLD);
+
+  const uint8_t *chunk = gray_chunk_.data();
+  uint8_t *local = local_out_.data();
+
+  if (options_.stencil != SobelStencil::kSobel) {
+    const SobelStencil stencil = options_.stencil;
+    // Output rows within the stencil radius of the image edge and the border columns stay zero.
+    ZeroStripBorder(local, w, start_row, local_rows, h, radius);
+    const std::size_t y_begin = std::min(local_rows, radius > start_row ? radius - start_row : 0);
+    const std::size_t y_end =
+        std::max(y_begin, std::min(local_rows, h - radius > start_row ? h - radius - start_row : 0));
+
+#pragma omp parallel for default(none) shared(stencil, chunk, local, w, y_begin, y_end, halo_top, radius) \
+    schedule(static) num_threads(ppc::util::GetNumThreads())
+    for (std::size_t y = y_begin; y < y_end; ++y) {
+      StencilGrayRowsOf(stencil, chunk + ((y + halo_top - radius) * w), w, 1, local + (y * w));
+    }
+  } else if (options_.traversal == SobelTraversal::kTiles) {
+    // Global border rows and the border columns are left out of the grid; only they are cleared here.
+    ZeroStripBorder(local, w, start_row, local_rows, h);
+    const std::size_t y_begin = (start_row == 0) ? 1 : 0;
+    std::size_t y_end = local_rows;
+    if (local_rows > 0 && start_row + local_rows == h) {
+      y_end = local_rows - 1;
+    }
+    if (y_begin < y_end) {
+      const SobelTileGrid grid(w, y_end - y_begin, options_);
+      const std::size_t num_tiles = grid.Count();
+      const uint8_t *src = chunk + ((y_begin + halo_top - 1) * w);
+      uint8_t *dst = local + (y_begin * w);
+
+#pragma omp parallel for default(none) shared(grid, src, dst, w, num_tiles) schedule(static) \
+    num_threads(ppc::util::GetNumThreads())
+      for (std::size_t i = 0; i < num_tiles; ++i) {
+        SobelTileRows(src, dst, w, grid.Tile(i));
+      }
+    }
+  } else {
+    // The strip assigned to this rank is shared among its OpenMP threads row by row.
+#pragma omp parallel for default(none) shared(chunk, local, w, h, local_rows, start_row, halo_top) schedule(static) \
+    num_threads(ppc::util::GetNumThreads())
+    for (std::size_t y = 0; y < local_rows; ++y) {
+      const std::size_t global_y = start_row + y;
+      uint8_t *dst = local + (y * w);
+
+      if (global_y == 0 || global_y + 1 == h) {
+        std::fill(dst, dst + w, 0);
+        continue;
+      }
+
+      const std::size_t cy = y + halo_top;
+      const uint8_t *above = chunk + ((cy - 1) * w);
+      const uint8_t *row = chunk + (cy * w);
+      const uint8_t *below = chunk + ((cy + 1) * w);
+
+      dst[0] = 0;
+      dst[w - 1] = 0;
+
+      SobelRow(above, row, below, dst, 1, w - 1);
+    }
+  }
+
+  MPI_Gatherv(local_out_.data(), static_cast<int>(local_rows), row_type_,
+              rank == 0 ? workspace_.out.data() : nullptr, rank == 0 ? recvcounts_out_.data() : nullptr,
+              rank == 0 ? displs_out_.data() : nullptr, row_type_, 0, MPI_COMM_WORLD);
+  return true;
+}
+
+bool SobelEdgeDetectionALL::PostProcessingImpl() {
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  if (rank == 0) {
+    auto &out = GetOutput();
+    workspace_.LendOut(out.data);
+    return (out.data.size() == out.width * out.height * out.channels);
+  }
+
+  return true;
+}
+
+}  // namespace rychkova_d_sobel_edge_detection
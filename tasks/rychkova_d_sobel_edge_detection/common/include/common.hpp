@@ -2,23 +2,295 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <new>
 #include <string>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include "task/include/task.hpp"
 
 namespace rychkova_d_sobel_edge_detection {
 
-struct Image {
-  std::vector<uint8_t> data;
+/// @brief Arrangement of the colour channels in Image::data.
+enum class PixelLayout : uint8_t {
+  /// channels values per pixel, pixel after pixel: gray (1 channel) or RGB (3 channels)
+  kInterleaved,
+  /// Three full width x height planes: all red values, then all green, then all blue (3 channels)
+  kPlanar,
+  /// R, G, B, A bytes per pixel; alpha is ignored (4 channels)
+  kRgba,
+  /// B, G, R, A bytes per pixel; alpha is ignored (4 channels)
+  kBgra
+};
+
+/// @brief Alignment of every pixel buffer: one cache line, and the width of an AVX-512 register.
+inline constexpr std::size_t kImageAlignment = 64;
+
+/// @brief Allocator of kImageAlignment-aligned storage, so buffers (and rows with an aligned pitch) start on a
+///        cache line and vector loads from them never split one.
+template <typename T>
+struct AlignedAllocator {
+  using value_type = T;
+
+  AlignedAllocator() = default;
+  template <typename U>
+  explicit(false) AlignedAllocator(const AlignedAllocator<U> & /*other*/) noexcept {}
+
+  T *allocate(std::size_t n) {
+    return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t{kImageAlignment}));
+  }
+  void deallocate(T *p, std::size_t /*n*/) noexcept {
+    ::operator delete(p, std::align_val_t{kImageAlignment});
+  }
+
+  template <typename U>
+  bool operator==(const AlignedAllocator<U> & /*other*/) const noexcept {
+    return true;
+  }
+};
+
+/// @brief Pixel storage of images and of the frames the tasks build from them.
+template <typename Pixel>
+using PixelBuffer = std::vector<Pixel, AlignedAllocator<Pixel>>;
+
+/// @brief Image with @p Pixel samples: uint8_t, uint16_t (12/16-bit sensors) or float.
+/// @details Row y starts at data[offset + y * RowPitch()]. The defaults describe packed rows; a larger stride pads
+///          the rows (see MakePaddedImage), and offset plus stride place a region of interest inside a larger
+///          buffer (see Roi). Planar images are always packed. Outputs of the tasks are packed.
+template <typename Pixel>
+struct BasicImage {
+  PixelBuffer<Pixel> data;
   std::size_t width = 0;
   std::size_t height = 0;
   std::size_t channels = 1;
+  PixelLayout layout = PixelLayout::kInterleaved;
+  /// Elements from the start of one row to the start of the next; 0 means width * channels.
+  std::size_t stride = 0;
+  /// Element of data holding the first sample of row 0.
+  std::size_t offset = 0;
+
+  [[nodiscard]] std::size_t RowPitch() const {
+    return stride != 0 ? stride : width * channels;
+  }
+  /// @brief Whether the rows follow each other without gaps from the start of data.
+  [[nodiscard]] bool Packed() const {
+    return offset == 0 && RowPitch() == width * channels;
+  }
+  [[nodiscard]] const Pixel *Row(std::size_t y) const {
+    return data.data() + offset + (y * RowPitch());
+  }
+  [[nodiscard]] Pixel *Row(std::size_t y) {
+    return data.data() + offset + (y * RowPitch());
+  }
+};
+
+/// @brief Whether the buffer of @p img holds all of its rows: exactly width * height pixels when packed; up to the
+///        end of the last row, with a stride of at least one row, otherwise.
+template <typename Pixel>
+bool ValidImageBuffer(const BasicImage<Pixel> &img) {
+  const std::size_t row = img.width * img.channels;
+  if (img.stride == 0 && img.offset == 0) {
+    return img.data.size() == row * img.height;
+  }
+  if (img.layout == PixelLayout::kPlanar || img.RowPitch() < row || img.offset > img.data.size()) {
+    return false;
+  }
+  return img.height == 0 || ((img.height - 1) * img.RowPitch()) + row <= img.data.size() - img.offset;
+}
+
+/// @brief Row pitch, in elements, of rows of @p row_elements samples rounded up to whole kImageAlignment lines.
+template <typename Pixel>
+constexpr std::size_t AlignedPitch(std::size_t row_elements) {
+  constexpr std::size_t kLine = kImageAlignment / sizeof(Pixel);
+  return (row_elements + kLine - 1) / kLine * kLine;
+}
+
+/// @brief Zeroed interleaved image whose rows are padded to AlignedPitch, so every row starts on a cache line.
+template <typename Pixel>
+BasicImage<Pixel> MakePaddedImage(std::size_t width, std::size_t height, std::size_t channels = 1,
+                                  PixelLayout layout = PixelLayout::kInterleaved) {
+  const std::size_t pitch = AlignedPitch<Pixel>(width * channels);
+  return BasicImage<Pixel>{.data = PixelBuffer<Pixel>(pitch * height),
+                           .width = width,
+                           .height = height,
+                           .channels = channels,
+                           .layout = layout,
+                           .stride = pitch};
+}
+
+/// @brief The @p width x @p height region of @p img whose top-left pixel is (x, y).
+/// @details The buffer moves into the result and only the geometry changes, so no pixel is copied; the tasks
+///          read the region in place. Interleaved, RGBA and BGRA images only.
+template <typename Pixel>
+BasicImage<Pixel> Roi(BasicImage<Pixel> &&img, std::size_t x, std::size_t y, std::size_t width, std::size_t height) {
+  img.offset += (y * img.RowPitch()) + (x * img.channels);
+  img.stride = img.RowPitch();
+  img.width = width;
+  img.height = height;
+  return std::move(img);
+}
+
+using Image = BasicImage<uint8_t>;
+using Image16 = BasicImage<uint16_t>;
+using ImageF32 = BasicImage<float>;
+
+/// @brief Gradient stencil the tasks apply; output pixels within its radius of the image edge are zero.
+/// @details Every stencil is separable into a smoothing and a derivative pass (see sobel_stencil.hpp) and normalized
+///          so that a step of height v yields a magnitude of v per axis.
+enum class SobelStencil : uint8_t {
+  /// 3x3 Sobel: [1 2 1] smoothing, [-1 0 1] derivative
+  kSobel,
+  /// 3x3 Scharr: [3 10 3] smoothing, [-1 0 1] derivative; closer to rotation invariant than Sobel
+  kScharr,
+  /// 3x3 Prewitt: [1 1 1] smoothing, [-1 0 1] derivative
+  kPrewitt,
+  /// 5x5 Sobel: [1 4 6 4 1] smoothing, [-1 -2 0 2 1] derivative; two-pixel zero border
+  kSobel5x5
+};
+
+/// @brief How the 3x3 Sobel stencil is evaluated.
+enum class SobelKernelMode : uint8_t {
+  /// Full 3x3 neighbourhood per output pixel (SIMD row kernel)
+  kDirect,
+  /// [1 2 1] / [-1 0 1] passes over a rolling three-row window of partial sums
+  kSeparable
+};
+
+/// @brief Where the RGB -> grayscale conversion happens.
+enum class SobelGrayMode : uint8_t {
+  /// A full grayscale frame is built in PreProcessing and read back by Run
+  kFrame,
+  /// Rows are converted on the fly into a three-row window consumed by the stencil right away
+  kFused
+};
+
+/// @brief Order in which the output image is swept.
+enum class SobelTraversal : uint8_t {
+  /// Full-width rows from top to bottom
+  kRows,
+  /// Cache-sized tiles of tile_width x tile_height output pixels, each finished before the next one starts;
+  /// tiles always run the direct kernel over a grayscale frame
+  kTiles
+};
+
+/// @brief How MPI ranks obtain the halo rows around their strip.
+enum class SobelHaloMode : uint8_t {
+  /// Rank 0 scatters overlapping strips that already contain the halo rows
+  kScatter,
+  /// Rank 0 scatters owned rows only; neighbouring ranks then swap their boundary rows
+  kExchange
+};
+
+/// @brief How MPI strips are moved between the root and the other ranks.
+enum class SobelCommMode : uint8_t {
+  /// One blocking Scatterv before and one blocking Gatherv after the computation
+  kBlocking,
+  /// comm_blocks Iscatterv/Igatherv pieces per strip, overlapped with the computation of the pieces already received
+  kOverlapped
+};
+
+/// @brief How MPI strips reach the ranks that filter them.
+enum class SobelTransport : uint8_t {
+  /// Scatterv/Gatherv messages between rank 0 and every other rank
+  kMessages,
+  /// Ranks of one node read their rows from and write their results into a node-wide MPI shared memory window;
+  /// only the node leaders exchange messages, one node strip each
+  kSharedWindow
+};
+
+/// @brief Where the MPI result ends up after PostProcessing.
+enum class SobelOutputMode : uint8_t {
+  /// Rank 0 gathers the full image into its output
+  kGathered,
+  /// Every rank keeps its own output rows as its output image, described by SobelEdgeDetectionMPI::GetOutputStrip;
+  /// SobelEdgeDetectionMPI::GatherOutput assembles the full image on rank 0 on request
+  kDistributed
+};
+
+/// @brief How the MPI implementation splits the image between ranks.
+enum class SobelDecomposition : uint8_t {
+  /// 2D blocks when they halve the halo boundary of row strips or ranks outnumber rows, and no strip-only option is set
+  kAuto,
+  /// Row strips
+  kRows,
+  /// 2D blocks on a Cartesian process grid whenever one with more than one column fits the image;
+  /// blocks always run the direct kernel and cannot be combined with kExchange or kOverlapped
+  kBlocks
+};
+
+/// @brief Execution options shared by the Sobel implementations.
+struct SobelOptions {
+  /// kernel, gray and traversal tune kSobel only; the other stencils always run the stencil engine row by row over a
+  /// grayscale frame. In the MPI task they need blocking scattered row strips (kScatter, kBlocking, kMessages).
+  SobelStencil stencil = SobelStencil::kSobel;
+  SobelKernelMode kernel = SobelKernelMode::kDirect;
+  SobelGrayMode gray = SobelGrayMode::kFrame;
+  SobelTraversal traversal = SobelTraversal::kRows;
+  SobelHaloMode halo = SobelHaloMode::kScatter;
+  /// kOverlapped brings its halo rows along with the scattered pieces and cannot be combined with kExchange.
+  SobelCommMode comm = SobelCommMode::kBlocking;
+  std::size_t comm_blocks = 4;
+  SobelDecomposition decomposition = SobelDecomposition::kAuto;
+  /// kSharedWindow uses row strips and cannot be combined with kExchange, kOverlapped or kBlocks.
+  SobelTransport transport = SobelTransport::kMessages;
+  /// kDistributed uses row strips and cannot be combined with kBlocks.
+  SobelOutputMode output = SobelOutputMode::kGathered;
+  /// Frames in flight in the stream tasks (SobelStreamTBB); 0 picks twice the number of worker threads.
+  std::size_t stream_depth = 0;
+  /// Tile extents for SobelTraversal::kTiles; the defaults keep the (tile_height + 2) input rows and the
+  /// output tile of one tile (about 200 KiB) inside a typical per-core L2 cache.
+  std::size_t tile_width = 1024;
+  std::size_t tile_height = 96;
+  /// Output rows per strip of the out-of-core file task (SobelFileSEQ); it holds (strip_rows + 2) input rows and
+  /// strip_rows output rows at a time, whatever the image height.
+  std::size_t strip_rows = 256;
 };
 
 using InType = Image;
 using OutType = Image;
+/// @brief Sequence of video frames, the input and output of the stream tasks; each frame is processed like one Image.
+using FrameStream = std::vector<Image>;
+
+/// @brief Location of one image inside an ImageBatch.
+struct BatchEntry {
+  std::size_t offset = 0;  // first byte of the image in ImageBatch::data
+  std::size_t width = 0;
+  std::size_t height = 0;
+  std::size_t channels = 1;
+};
+
+/// @brief Many small images packed back to back into one buffer and located through an offset table; the input and
+///        output of the batch tasks. Each image is processed like one Image.
+struct ImageBatch {
+  std::vector<uint8_t> data;
+  std::vector<BatchEntry> entries;
+};
+
+/// @brief On-disk encodings of the out-of-core file task.
+enum class ImageFileFormat : uint8_t {
+  /// Headerless interleaved pixels; the geometry is given by ImageFile
+  kRaw,
+  /// Binary PGM (P5) or PPM (P6) with maxval 255; the geometry is read from the header and the output is PGM
+  kPnm
+};
+
+/// @brief Image stored in a file, filtered strip by strip without ever being loaded whole.
+struct ImageFile {
+  std::string path;
+  ImageFileFormat format = ImageFileFormat::kPnm;
+  // Required for kRaw input; read from the header for kPnm input. Always set on the output.
+  std::size_t width = 0;
+  std::size_t height = 0;
+  std::size_t channels = 1;
+};
+
+/// @brief Input of the out-of-core file task: the image to filter and the path its edge image is written to.
+struct ImageFileJob {
+  ImageFile input;
+  std::string output_path;
+};
+
 using TestType = std::tuple<InType, std::string>;
 using BaseTask = ppc::task::Task<InType, OutType>;
 
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "rychkova_d_sobel_edge_detection/common/include/common.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_fused.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_pixel.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_separable.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_stencil.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_tiles.hpp"
+
+namespace rychkova_d_sobel_edge_detection {
+
+/// @brief Scratch state of SobelFrame; keep one per worker thread so its buffers are reused from frame to frame.
+struct SobelFrameScratch {
+  PixelBuffer<uint8_t> gray;
+  SobelSeparableRing separable;
+  SobelFusedWindow fused;
+};
+
+/// @brief Whether an image with @p channels channels in @p layout is filtered from a grayscale frame under
+///        @p options; only interleaved RGB rows can be converted on the fly by the fused 3x3 Sobel kernel.
+inline bool NeedsGrayFrame(const SobelOptions &options, std::size_t channels,
+                           PixelLayout layout = PixelLayout::kInterleaved) {
+  const bool fused = options.stencil == SobelStencil::kSobel && options.gray == SobelGrayMode::kFused &&
+                     options.traversal == SobelTraversal::kRows;
+  return channels != 1 && (!fused || layout != PixelLayout::kInterleaved);
+}
+
+/// @brief Filters @p rows output rows from the (rows + 2 * radius) source rows around them on the calling thread,
+///        where radius is StencilRadius(options.stencil).
+/// @param src Interleaved source pixels with @p channels channels (1 or 3), starting radius rows above the first
+///            output row.
+/// @param dst rows x w output; the first and last radius columns are not written.
+inline void SobelWindow(const SobelOptions &options, const uint8_t *src, std::size_t channels, std::size_t w,
+                        std::size_t rows, SobelFrameScratch &scratch, uint8_t *dst) {
+  const std::size_t radius = StencilRadius(options.stencil);
+  if (w <= 2 * radius || rows == 0) {
+    return;
+  }
+
+  if (NeedsGrayFrame(options, channels)) {
+    const std::size_t pixels = w * (rows + (2 * radius));
+    if (scratch.gray.size() < pixels) {
+      scratch.gray.resize(pixels);
+    }
+    GrayRow(src, channels, scratch.gray.data(), pixels);
+    src = scratch.gray.data();
+    channels = 1;
+  }
+
+  if (options.stencil != SobelStencil::kSobel) {
+    StencilGrayRowsOf(options.stencil, src, w, rows, dst);
+  } else if (options.traversal == SobelTraversal::kTiles) {
+    const SobelTileGrid grid(w, rows, options);
+    for (std::size_t i = 0; i < grid.Count(); ++i) {
+      SobelTileRows(src, dst, w, grid.Tile(i));
+    }
+  } else if (channels == 1) {
+    SobelRows(options.kernel, scratch.separable, src, w, rows, dst);
+  } else {
+    scratch.fused.Process(options.kernel, src, channels, w, rows, dst);
+  }
+}
+
+/// @brief Edge image of one w x h frame on the calling thread; matches SobelEdgeDetectionSEQ with the same options.
+/// @param src Interleaved source pixels with @p channels channels (1 or 3).
+/// @param dst w x h output; the border pixels are not written, so clear them first (see ZeroBorder).
+inline void SobelFrame(const SobelOptions &options, const uint8_t *src, std::size_t channels, std::size_t w,
+                       std::size_t h, SobelFrameScratch &scratch, uint8_t *dst) {
+  const std::size_t radius = StencilRadius(options.stencil);
+  if (h <= 2 * radius) {
+    return;
+  }
+  SobelWindow(options, src, channels, w, h - (2 * radius), scratch, dst + (radius * w));
+}
+
+}  // namespace rychkova_d_sobel_edge_detection
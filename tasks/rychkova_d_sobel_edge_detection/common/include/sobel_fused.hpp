@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "rychkova_d_sobel_edge_detection/common/include/common.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_gray.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_kernel.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_separable.hpp"
+
+namespace rychkova_d_sobel_edge_detection {
+
+/// @brief Sobel evaluator that converts source rows to gray on the fly instead of reading a gray frame.
+/// @details Only the last three gray rows are kept, so the grayscale image is never written out in full and
+///          every source row is touched exactly once. Results match the two-pass path bit for bit.
+class SobelFusedWindow {
+ public:
+  /// @brief Computes @p rows output rows of width @p w into @p dst.
+  /// @param src First of rows + 2 consecutive interleaved source rows (the row above the first output row),
+  ///            @p src_pitch elements apart; 0 means w * channels.
+  /// @param dst First output row; only the interior columns are written by the direct kernel.
+  void Process(SobelKernelMode mode, const uint8_t *src, std::size_t channels, std::size_t w, std::size_t rows,
+               uint8_t *dst, std::size_t src_pitch = 0) {
+    if (rows == 0 || w < 3) {
+      return;
+    }
+    const std::size_t stride = src_pitch != 0 ? src_pitch : w * channels;
+
+    if (mode == SobelKernelMode::kSeparable) {
+      // The separable ring caches its own partial sums, so one scratch gray row is enough.
+      if (window_.size() < w) {
+        window_.resize(w);
+      }
+      separable_.Start(w);
+      for (std::size_t k = 0; k < rows + 2; ++k) {
+        GrayRow(src + (k * stride), channels, window_.data(), w);
+        separable_.Push(window_.data());
+        if (k >= 2) {
+          separable_.Emit(dst + ((k - 2) * w));
+        }
+      }
+      return;
+    }
+
+    if (window_.size() < kWindowRows * w) {
+      window_.resize(kWindowRows * w);
+    }
+    GrayRow(src, channels, Slot(0, w), w);
+    GrayRow(src + stride, channels, Slot(1, w), w);
+    for (std::size_t k = 0; k < rows; ++k) {
+      GrayRow(src + ((k + 2) * stride), channels, Slot(k + 2, w), w);
+      SobelRow(Slot(k, w), Slot(k + 1, w), Slot(k + 2, w), dst + (k * w), 1, w - 1);
+    }
+  }
+
+ private:
+  static constexpr std::size_t kWindowRows = 3;
+
+  uint8_t *Slot(std::size_t row, std::size_t w) {
+    return window_.data() + ((row % kWindowRows) * w);
+  }
+
+  std::vector<uint8_t> window_;
+  SobelSeparableRing separable_;
+};
+
+}  // namespace rychkova_d_sobel_edge_detection
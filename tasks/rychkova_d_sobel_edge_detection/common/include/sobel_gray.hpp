@@ -0,0 +1,239 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "rychkova_d_sobel_edge_detection/common/include/common.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_kernel.hpp"
+
+namespace rychkova_d_sobel_edge_detection {
+
+/// @brief Whether @p channels fits @p layout: 1 or 3 interleaved channels, 3 planes, or 4 RGBA/BGRA channels.
+inline bool ValidPixelFormat(std::size_t channels, PixelLayout layout) {
+  switch (layout) {
+    case PixelLayout::kInterleaved:
+      return channels == 1 || channels == 3;
+    case PixelLayout::kPlanar:
+      return channels == 3;
+    case PixelLayout::kRgba:
+    case PixelLayout::kBgra:
+      return channels == 4;
+  }
+  return false;
+}
+
+/// @brief Gray value of one pixel, (77 r + 150 g + 29 b) >> 8; every conversion kernel reproduces it exactly.
+inline uint8_t GrayOf(int r, int g, int b) {
+  return static_cast<uint8_t>((77 * r + 150 * g + 29 * b) >> 8);
+}
+
+inline void GrayRgbScalar(const uint8_t *src, uint8_t *dst, std::size_t n) {
+  for (std::size_t x = 0; x < n; ++x) {
+    dst[x] = GrayOf(src[(x * 3) + 0], src[(x * 3) + 1], src[(x * 3) + 2]);
+  }
+}
+
+inline void GrayPlanarScalar(const uint8_t *r, const uint8_t *g, const uint8_t *b, uint8_t *dst, std::size_t n) {
+  for (std::size_t x = 0; x < n; ++x) {
+    dst[x] = GrayOf(r[x], g[x], b[x]);
+  }
+}
+
+/// @param r_at Byte of red within each 4-byte pixel; blue sits at 2 - r_at and green at 1.
+inline void GrayQuadScalar(const uint8_t *src, std::size_t r_at, uint8_t *dst, std::size_t n) {
+  for (std::size_t x = 0; x < n; ++x) {
+    const uint8_t *px = src + (x * 4);
+    dst[x] = GrayOf(px[r_at], px[1], px[2 - r_at]);
+  }
+}
+
+#ifdef RYCHKOVA_D_SOBEL_X86
+
+// The weighted sum is at most 256 * 255, so 16-bit lanes hold it exactly and a logical shift by 8 matches GrayOf.
+
+RYCHKOVA_D_SOBEL_TARGET("sse2")
+inline __m128i GrayWordsSse2(__m128i r, __m128i g, __m128i b) {
+  const __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(77)),
+                                                  _mm_mullo_epi16(g, _mm_set1_epi16(150))),
+                                    _mm_mullo_epi16(b, _mm_set1_epi16(29)));
+  return _mm_srli_epi16(sum, 8);
+}
+
+/// Interleaved RGB, 16 pixels (48 bytes) per iteration: pshufb gathers every channel out of the three loads.
+RYCHKOVA_D_SOBEL_TARGET("ssse3")
+inline void GrayRgbSsse3(const uint8_t *src, uint8_t *dst, std::size_t n) {
+  constexpr std::size_t kStep = 16;
+  const __m128i r0 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m128i r1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+  const __m128i r2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+  const __m128i g0 = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m128i g1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+  const __m128i g2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+  const __m128i b0 = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m128i b1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+  const __m128i b2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+  const __m128i zero = _mm_setzero_si128();
+
+  std::size_t x = 0;
+  for (; x + kStep <= n; x += kStep) {
+    const uint8_t *p = src + (x * 3);
+    const __m128i c0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    const __m128i c1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16));
+    const __m128i c2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 32));
+    const __m128i r = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(c0, r0), _mm_shuffle_epi8(c1, r1)),
+                                   _mm_shuffle_epi8(c2, r2));
+    const __m128i g = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(c0, g0), _mm_shuffle_epi8(c1, g1)),
+                                   _mm_shuffle_epi8(c2, g2));
+    const __m128i b = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(c0, b0), _mm_shuffle_epi8(c1, b1)),
+                                   _mm_shuffle_epi8(c2, b2));
+
+    const __m128i lo = GrayWordsSse2(_mm_unpacklo_epi8(r, zero), _mm_unpacklo_epi8(g, zero),
+                                     _mm_unpacklo_epi8(b, zero));
+    const __m128i hi = GrayWordsSse2(_mm_unpackhi_epi8(r, zero), _mm_unpackhi_epi8(g, zero),
+                                     _mm_unpackhi_epi8(b, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x), _mm_packus_epi16(lo, hi));
+  }
+  GrayRgbScalar(src + (x * 3), dst + x, n - x);
+}
+
+RYCHKOVA_D_SOBEL_TARGET("avx2")
+inline __m256i GrayWordsAvx2(__m256i r, __m256i g, __m256i b) {
+  const __m256i sum = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(r, _mm256_set1_epi16(77)),
+                                                        _mm256_mullo_epi16(g, _mm256_set1_epi16(150))),
+                                       _mm256_mullo_epi16(b, _mm256_set1_epi16(29)));
+  return _mm256_srli_epi16(sum, 8);
+}
+
+/// Planar RGB, 32 pixels per iteration straight from the three planes.
+RYCHKOVA_D_SOBEL_TARGET("avx2")
+inline void GrayPlanarAvx2(const uint8_t *r, const uint8_t *g, const uint8_t *b, uint8_t *dst, std::size_t n) {
+  constexpr std::size_t kStep = 32;
+  std::size_t x = 0;
+  for (; x + kStep <= n; x += kStep) {
+    const __m256i rv = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(r + x));
+    const __m256i gv = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(g + x));
+    const __m256i bv = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + x));
+    const __m256i lo = GrayWordsAvx2(WidenLoAvx2(rv), WidenLoAvx2(gv), WidenLoAvx2(bv));
+    const __m256i hi = GrayWordsAvx2(WidenHiAvx2(rv), WidenHiAvx2(gv), WidenHiAvx2(bv));
+    // packus works per 128-bit lane, so restore the pixel order afterwards.
+    const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x), packed);
+  }
+  GrayPlanarScalar(r + x, g + x, b + x, dst + x, n - x);
+}
+
+// Gray values of 8 four-byte pixels as 32-bit lanes: madd_epi16 weighs bytes 0 and 2 of every pixel in one step and
+// bytes 1 and 3 (green and alpha, the latter with weight 0) in another.
+RYCHKOVA_D_SOBEL_TARGET("avx2")
+inline __m256i GrayQuadLanesAvx2(const uint8_t *p, __m256i w02, __m256i w13) {
+  const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+  const __m256i b02 = _mm256_and_si256(v, _mm256_set1_epi32(0x00FF00FF));
+  const __m256i b13 = _mm256_srli_epi16(v, 8);
+  return _mm256_srli_epi32(_mm256_add_epi32(_mm256_madd_epi16(b02, w02), _mm256_madd_epi16(b13, w13)), 8);
+}
+
+/// RGBA or BGRA, 32 pixels per iteration.
+RYCHKOVA_D_SOBEL_TARGET("avx2")
+inline void GrayQuadAvx2(const uint8_t *src, std::size_t r_at, uint8_t *dst, std::size_t n) {
+  constexpr std::size_t kStep = 32;
+  const __m256i w02 = r_at == 0 ? _mm256_set1_epi32((29 << 16) | 77) : _mm256_set1_epi32((77 << 16) | 29);
+  const __m256i w13 = _mm256_set1_epi32(150);
+  // Undoes the per-lane interleaving of the two packs below.
+  const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  std::size_t x = 0;
+  for (; x + kStep <= n; x += kStep) {
+    const uint8_t *p = src + (x * 4);
+    const __m256i y0 = GrayQuadLanesAvx2(p, w02, w13);
+    const __m256i y1 = GrayQuadLanesAvx2(p + 32, w02, w13);
+    const __m256i y2 = GrayQuadLanesAvx2(p + 64, w02, w13);
+    const __m256i y3 = GrayQuadLanesAvx2(p + 96, w02, w13);
+    const __m256i bytes = _mm256_packus_epi16(_mm256_packus_epi32(y0, y1), _mm256_packus_epi32(y2, y3));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x), _mm256_permutevar8x32_epi32(bytes, order));
+  }
+  GrayQuadScalar(src + (x * 4), r_at, dst + x, n - x);
+}
+
+#endif  // RYCHKOVA_D_SOBEL_X86
+
+// The kernels above need SSSE3 or AVX2; every CPU with AVX2 has SSSE3, so one level check covers them all.
+inline bool UseGraySimd() {
+#ifdef RYCHKOVA_D_SOBEL_X86
+  return ActiveSobelSimdLevel() >= SobelSimdLevel::kAvx2;
+#else
+  return false;
+#endif
+}
+
+/// @brief Converts @p w pixels with @p channels interleaved channels (1 or 3) to grayscale.
+inline void GrayRow(const uint8_t *src, std::size_t channels, uint8_t *dst, std::size_t w) {
+  if (channels == 1) {
+    std::memcpy(dst, src, w);
+    return;
+  }
+#ifdef RYCHKOVA_D_SOBEL_X86
+  if (UseGraySimd()) {
+    GrayRgbSsse3(src, dst, w);
+    return;
+  }
+#endif
+  GrayRgbScalar(src, dst, w);
+}
+
+/// @brief Pixels per chunk when the conversion of a frame is spread over threads; large enough to amortize the
+///        scheduling, small enough to balance.
+inline constexpr std::size_t kGrayChunkPixels = 16384;
+
+/// @brief Converts @p n consecutive pixels in @p layout starting at @p src: a packed frame or part of one row.
+/// @param plane Distance between the colour planes of a planar image.
+inline void GrayRun(PixelLayout layout, std::size_t channels, std::size_t plane, const uint8_t *src, uint8_t *dst,
+                    std::size_t n) {
+  [[maybe_unused]] const bool simd = UseGraySimd();
+  switch (layout) {
+    case PixelLayout::kInterleaved:
+      GrayRow(src, channels, dst, n);
+      return;
+    case PixelLayout::kPlanar:
+#ifdef RYCHKOVA_D_SOBEL_X86
+      if (simd) {
+        GrayPlanarAvx2(src, src + plane, src + (2 * plane), dst, n);
+        return;
+      }
+#endif
+      GrayPlanarScalar(src, src + plane, src + (2 * plane), dst, n);
+      return;
+    case PixelLayout::kRgba:
+    case PixelLayout::kBgra: {
+      const std::size_t r_at = layout == PixelLayout::kRgba ? 0 : 2;
+#ifdef RYCHKOVA_D_SOBEL_X86
+      if (simd) {
+        GrayQuadAvx2(src, r_at, dst, n);
+        return;
+      }
+#endif
+      GrayQuadScalar(src, r_at, dst, n);
+      return;
+    }
+  }
+}
+
+/// @brief Converts pixels [begin, end) of @p img to grayscale into dst[begin, end), for any PixelLayout.
+/// @details Pixel ranges are independent, so parallel callers split the frame into ranges of any size. Packed images
+///          are converted in one run; strided ones row segment by row segment, straight from their rows.
+inline void GrayPixels(const Image &img, uint8_t *dst, std::size_t begin, std::size_t end) {
+  const std::size_t plane = img.width * img.height;
+  if (img.Packed()) {
+    const std::size_t step = img.layout == PixelLayout::kPlanar ? 1 : img.channels;
+    GrayRun(img.layout, img.channels, plane, img.data.data() + (begin * step), dst + begin, end - begin);
+    return;
+  }
+  for (std::size_t i = begin; i < end;) {
+    const std::size_t x = i % img.width;
+    const std::size_t n = std::min(end - i, img.width - x);
+    GrayRun(img.layout, img.channels, plane, img.Row(i / img.width) + (x * img.channels), dst + i, n);
+    i += n;
+  }
+}
+
+}  // namespace rychkova_d_sobel_edge_detection
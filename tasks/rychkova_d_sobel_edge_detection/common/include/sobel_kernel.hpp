@@ -0,0 +1,246 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_stencil.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#  define RYCHKOVA_D_SOBEL_X86 1
+#  include <immintrin.h>
+#  if defined(_MSC_VER) && !defined(__clang__)
+#    include <intrin.h>
+#  endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#  define RYCHKOVA_D_SOBEL_TARGET(isa) __attribute__((target(isa)))
+#else
+#  define RYCHKOVA_D_SOBEL_TARGET(isa)
+#endif
+
+namespace rychkova_d_sobel_edge_detection {
+
+/// @brief Instruction set used by the Sobel row kernel.
+enum class SobelSimdLevel : uint8_t {
+  /// Portable scalar loop
+  kScalar,
+  /// 16 pixels per iteration with SSE2
+  kSse2,
+  /// 32 pixels per iteration with AVX2
+  kAvx2,
+  /// 32 pixels per iteration with AVX-512BW
+  kAvx512
+};
+
+/// @brief Scalar Sobel magnitude of pixel @p x: (|gx| + |gy|) / 4 clamped to [0, 255].
+inline uint8_t SobelPixel(const uint8_t *above, const uint8_t *row, const uint8_t *below, std::size_t x) {
+  return StencilPixel<Sobel3x3Stencil, uint8_t>({above, row, below}, x);
+}
+
+/// @brief Computes dst[x] for x in [x_begin, x_end) from three consecutive gray rows.
+/// @details Requires 1 <= x_begin and x_end + 1 <= row width.
+inline void SobelRowScalar(const uint8_t *above, const uint8_t *row, const uint8_t *below, uint8_t *dst,
+                           std::size_t x_begin, std::size_t x_end) {
+  StencilRow<Sobel3x3Stencil, uint8_t>({above, row, below}, dst, x_begin, x_end);
+}
+
+#ifdef RYCHKOVA_D_SOBEL_X86
+
+// All SIMD paths widen to 16-bit lanes: |gx| + |gy| <= 2040, so no lane can overflow and
+// (|gx| + |gy|) >> 2 followed by unsigned saturation to u8 reproduces the scalar clamp exactly.
+
+RYCHKOVA_D_SOBEL_TARGET("sse2")
+inline __m128i SobelLanesSse2(__m128i a0, __m128i a1, __m128i a2, __m128i r0, __m128i r2, __m128i b0, __m128i b1,
+                              __m128i b2) {
+  const __m128i gx = _mm_add_epi16(_mm_add_epi16(_mm_sub_epi16(a2, a0), _mm_sub_epi16(b2, b0)),
+                                   _mm_slli_epi16(_mm_sub_epi16(r2, r0), 1));
+  const __m128i gy = _mm_sub_epi16(_mm_add_epi16(_mm_add_epi16(b0, b2), _mm_slli_epi16(b1, 1)),
+                                   _mm_add_epi16(_mm_add_epi16(a0, a2), _mm_slli_epi16(a1, 1)));
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i abs_gx = _mm_max_epi16(gx, _mm_sub_epi16(zero, gx));
+  const __m128i abs_gy = _mm_max_epi16(gy, _mm_sub_epi16(zero, gy));
+  return _mm_srli_epi16(_mm_add_epi16(abs_gx, abs_gy), 2);
+}
+
+RYCHKOVA_D_SOBEL_TARGET("sse2")
+inline void SobelRowSse2(const uint8_t *above, const uint8_t *row, const uint8_t *below, uint8_t *dst,
+                         std::size_t x_begin, std::size_t x_end) {
+  constexpr std::size_t kStep = 16;
+  const __m128i zero = _mm_setzero_si128();
+  std::size_t x = x_begin;
+  for (; x + kStep <= x_end; x += kStep) {
+    const __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(above + x - 1));
+    const __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(above + x));
+    const __m128i a2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(above + x + 1));
+    const __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x - 1));
+    const __m128i r2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x + 1));
+    const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(below + x - 1));
+    const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(below + x));
+    const __m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(below + x + 1));
+
+    const __m128i lo =
+        SobelLanesSse2(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(a2, zero),
+                       _mm_unpacklo_epi8(r0, zero), _mm_unpacklo_epi8(r2, zero), _mm_unpacklo_epi8(b0, zero),
+                       _mm_unpacklo_epi8(b1, zero), _mm_unpacklo_epi8(b2, zero));
+    const __m128i hi =
+        SobelLanesSse2(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(a2, zero),
+                       _mm_unpackhi_epi8(r0, zero), _mm_unpackhi_epi8(r2, zero), _mm_unpackhi_epi8(b0, zero),
+                       _mm_unpackhi_epi8(b1, zero), _mm_unpackhi_epi8(b2, zero));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x), _mm_packus_epi16(lo, hi));
+  }
+  SobelRowScalar(above, row, below, dst, x, x_end);
+}
+
+RYCHKOVA_D_SOBEL_TARGET("avx2")
+inline __m256i SobelLanesAvx2(__m256i a0, __m256i a1, __m256i a2, __m256i r0, __m256i r2, __m256i b0, __m256i b1,
+                              __m256i b2) {
+  const __m256i gx = _mm256_add_epi16(_mm256_add_epi16(_mm256_sub_epi16(a2, a0), _mm256_sub_epi16(b2, b0)),
+                                      _mm256_slli_epi16(_mm256_sub_epi16(r2, r0), 1));
+  const __m256i gy = _mm256_sub_epi16(_mm256_add_epi16(_mm256_add_epi16(b0, b2), _mm256_slli_epi16(b1, 1)),
+                                      _mm256_add_epi16(_mm256_add_epi16(a0, a2), _mm256_slli_epi16(a1, 1)));
+  return _mm256_srli_epi16(_mm256_add_epi16(_mm256_abs_epi16(gx), _mm256_abs_epi16(gy)), 2);
+}
+
+RYCHKOVA_D_SOBEL_TARGET("avx2")
+inline __m256i WidenLoAvx2(__m256i v) {
+  return _mm256_cvtepu8_epi16(_mm256_castsi256_si128(v));
+}
+
+RYCHKOVA_D_SOBEL_TARGET("avx2")
+inline __m256i WidenHiAvx2(__m256i v) {
+  return _mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1));
+}
+
+RYCHKOVA_D_SOBEL_TARGET("avx2")
+inline void SobelRowAvx2(const uint8_t *above, const uint8_t *row, const uint8_t *below, uint8_t *dst,
+                         std::size_t x_begin, std::size_t x_end) {
+  constexpr std::size_t kStep = 32;
+  std::size_t x = x_begin;
+  for (; x + kStep <= x_end; x += kStep) {
+    const __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(above + x - 1));
+    const __m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(above + x));
+    const __m256i a2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(above + x + 1));
+    const __m256i r0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + x - 1));
+    const __m256i r2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + x + 1));
+    const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(below + x - 1));
+    const __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(below + x));
+    const __m256i b2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(below + x + 1));
+
+    const __m256i lo = SobelLanesAvx2(WidenLoAvx2(a0), WidenLoAvx2(a1), WidenLoAvx2(a2), WidenLoAvx2(r0),
+                                      WidenLoAvx2(r2), WidenLoAvx2(b0), WidenLoAvx2(b1), WidenLoAvx2(b2));
+    const __m256i hi = SobelLanesAvx2(WidenHiAvx2(a0), WidenHiAvx2(a1), WidenHiAvx2(a2), WidenHiAvx2(r0),
+                                      WidenHiAvx2(r2), WidenHiAvx2(b0), WidenHiAvx2(b1), WidenHiAvx2(b2));
+
+    // packus works per 128-bit lane, so restore the pixel order afterwards.
+    const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x), packed);
+  }
+  SobelRowScalar(above, row, below, dst, x, x_end);
+}
+
+RYCHKOVA_D_SOBEL_TARGET("avx512f,avx512bw")
+inline __m512i LoadWidenAvx512(const uint8_t *p) {
+  return _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)));
+}
+
+RYCHKOVA_D_SOBEL_TARGET("avx512f,avx512bw")
+inline void SobelRowAvx512(const uint8_t *above, const uint8_t *row, const uint8_t *below, uint8_t *dst,
+                           std::size_t x_begin, std::size_t x_end) {
+  constexpr std::size_t kStep = 32;
+  std::size_t x = x_begin;
+  for (; x + kStep <= x_end; x += kStep) {
+    const __m512i a0 = LoadWidenAvx512(above + x - 1);
+    const __m512i a1 = LoadWidenAvx512(above + x);
+    const __m512i a2 = LoadWidenAvx512(above + x + 1);
+    const __m512i r0 = LoadWidenAvx512(row + x - 1);
+    const __m512i r2 = LoadWidenAvx512(row + x + 1);
+    const __m512i b0 = LoadWidenAvx512(below + x - 1);
+    const __m512i b1 = LoadWidenAvx512(below + x);
+    const __m512i b2 = LoadWidenAvx512(below + x + 1);
+
+    const __m512i gx = _mm512_add_epi16(_mm512_add_epi16(_mm512_sub_epi16(a2, a0), _mm512_sub_epi16(b2, b0)),
+                                        _mm512_slli_epi16(_mm512_sub_epi16(r2, r0), 1));
+    const __m512i gy = _mm512_sub_epi16(_mm512_add_epi16(_mm512_add_epi16(b0, b2), _mm512_slli_epi16(b1, 1)),
+                                        _mm512_add_epi16(_mm512_add_epi16(a0, a2), _mm512_slli_epi16(a1, 1)));
+    const __m512i mag = _mm512_srli_epi16(_mm512_add_epi16(_mm512_abs_epi16(gx), _mm512_abs_epi16(gy)), 2);
+
+    // The zero-masked form with a full mask avoids reading an undefined pass-through register.
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x), _mm512_maskz_cvtusepi16_epi8(0xFFFFFFFFU, mag));
+  }
+  SobelRowScalar(above, row, below, dst, x, x_end);
+}
+
+#endif  // RYCHKOVA_D_SOBEL_X86
+
+/// @brief Queries the CPU for the widest Sobel kernel it can run.
+inline SobelSimdLevel DetectSobelSimdLevel() {
+#if defined(RYCHKOVA_D_SOBEL_X86) && (defined(__GNUC__) || defined(__clang__))
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512bw") != 0) {
+    return SobelSimdLevel::kAvx512;
+  }
+  if (__builtin_cpu_supports("avx2") != 0) {
+    return SobelSimdLevel::kAvx2;
+  }
+  return SobelSimdLevel::kSse2;
+#elif defined(RYCHKOVA_D_SOBEL_X86) && defined(_MSC_VER)
+  int regs[4] = {0, 0, 0, 0};
+  __cpuid(regs, 1);
+  const bool os_avx = ((regs[2] >> 27) & 1) != 0 && ((regs[2] >> 28) & 1) != 0;
+  if (!os_avx) {
+    return SobelSimdLevel::kSse2;
+  }
+  const auto xcr0 = _xgetbv(0);
+  __cpuidex(regs, 7, 0);
+  const bool avx2 = ((regs[1] >> 5) & 1) != 0 && (xcr0 & 0x6) == 0x6;
+  const bool avx512bw = ((regs[1] >> 16) & 1) != 0 && ((regs[1] >> 30) & 1) != 0 && (xcr0 & 0xE6) == 0xE6;
+  if (avx512bw) {
+    return SobelSimdLevel::kAvx512;
+  }
+  return avx2 ? SobelSimdLevel::kAvx2 : SobelSimdLevel::kSse2;
+#else
+  return SobelSimdLevel::kScalar;
+#endif
+}
+
+/// @brief Kernel level picked for this process; detected once on first use.
+inline SobelSimdLevel ActiveSobelSimdLevel() {
+  static const SobelSimdLevel kLevel = DetectSobelSimdLevel();
+  return kLevel;
+}
+
+/// @brief Computes dst[x] for x in [x_begin, x_end) with the requested kernel.
+/// @details Requires 1 <= x_begin and x_end + 1 <= row width; @p level must not exceed DetectSobelSimdLevel().
+inline void SobelRow(SobelSimdLevel level, const uint8_t *above, const uint8_t *row, const uint8_t *below,
+                     uint8_t *dst, std::size_t x_begin, std::size_t x_end) {
+  switch (level) {
+#ifdef RYCHKOVA_D_SOBEL_X86
+    case SobelSimdLevel::kAvx512:
+      SobelRowAvx512(above, row, below, dst, x_begin, x_end);
+      return;
+    case SobelSimdLevel::kAvx2:
+      SobelRowAvx2(above, row, below, dst, x_begin, x_end);
+      return;
+    case SobelSimdLevel::kSse2:
+      SobelRowSse2(above, row, below, dst, x_begin, x_end);
+      return;
+#else
+    case SobelSimdLevel::kAvx512:
+    case SobelSimdLevel::kAvx2:
+    case SobelSimdLevel::kSse2:
+#endif
+    case SobelSimdLevel::kScalar:
+      SobelRowScalar(above, row, below, dst, x_begin, x_end);
+      return;
+  }
+}
+
+/// @brief Computes dst[x] for x in [x_begin, x_end) with the fastest kernel supported by the CPU.
+inline void SobelRow(const uint8_t *above, const uint8_t *row, const uint8_t *below, uint8_t *dst,
+                     std::size_t x_begin, std::size_t x_end) {
+  SobelRow(ActiveSobelSimdLevel(), above, row, below, dst, x_begin, x_end);
+}
+
+}  // namespace rychkova_d_sobel_edge_detection
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "rychkova_d_sobel_edge_detection/common/include/common.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_gray.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_kernel.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_stencil.hpp"
+
+namespace rychkova_d_sobel_edge_detection {
+
+/// @brief Whether @p Pixel runs the full u8 pipeline (SIMD, separable and fused kernels) rather than the typed one.
+template <typename Pixel>
+inline constexpr bool kIsU8Pixel = std::is_same_v<Pixel, uint8_t>;
+
+/// @brief Scalar Sobel magnitude of pixel @p x for any pixel type; the operation order matches the SIMD kernels.
+template <typename Pixel>
+Pixel SobelPixelOf(const Pixel *above, const Pixel *row, const Pixel *below, std::size_t x) {
+  return StencilPixel<Sobel3x3Stencil, Pixel>({above, row, below}, x);
+}
+
+template <typename Pixel>
+void SobelRowScalarOf(const Pixel *above, const Pixel *row, const Pixel *below, Pixel *dst, std::size_t x_begin,
+                      std::size_t x_end) {
+  StencilRow<Sobel3x3Stencil, Pixel>({above, row, below}, dst, x_begin, x_end);
+}
+
+#ifdef RYCHKOVA_D_SOBEL_X86
+
+// u16 widens to 32-bit lanes, 16 pixels per iteration; packus_epi32 saturates (|gx| + |gy|) >> 2 to 65535 exactly
+// like the scalar clamp.
+
+RYCHKOVA_D_SOBEL_TARGET("avx2")
+inline __m256i LoadWidenU16Avx2(const uint16_t *p) {
+  return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+}
+
+RYCHKOVA_D_SOBEL_TARGET("avx2")
+inline __m256i SobelLanesU16Avx2(const uint16_t *above, const uint16_t *row, const uint16_t *below, std::size_t x) {
+  const __m256i a0 = LoadWidenU16Avx2(above + x - 1);
+  const __m256i a1 = LoadWidenU16Avx2(above + x);
+  const __m256i a2 = LoadWidenU16Avx2(above + x + 1);
+  const __m256i r0 = LoadWidenU16Avx2(row + x - 1);
+  const __m256i r2 = LoadWidenU16Avx2(row + x + 1);
+  const __m256i b0 = LoadWidenU16Avx2(below + x - 1);
+  const __m256i b1 = LoadWidenU16Avx2(below + x);
+  const __m256i b2 = LoadWidenU16Avx2(below + x + 1);
+
+  const __m256i gx = _mm256_add_epi32(_mm256_add_epi32(_mm256_sub_epi32(a2, a0), _mm256_sub_epi32(b2, b0)),
+                                      _mm256_slli_epi32(_mm256_sub_epi32(r2, r0), 1));
+  const __m256i gy = _mm256_sub_epi32(_mm256_add_epi32(_mm256_add_epi32(b0, b2), _mm256_slli_epi32(b1, 1)),
+                                      _mm256_add_epi32(_mm256_add_epi32(a0, a2), _mm256_slli_epi32(a1, 1)));
+  return _mm256_srli_epi32(_mm256_add_epi32(_mm256_abs_epi32(gx), _mm256_abs_epi32(gy)), 2);
+}
+
+RYCHKOVA_D_SOBEL_TARGET("avx2")
+inline void SobelRowU16Avx2(const uint16_t *above, const uint16_t *row, const uint16_t *below, uint16_t *dst,
+                            std::size_t x_begin, std::size_t x_end) {
+  constexpr std::size_t kStep = 16;
+  std::size_t x = x_begin;
+  for (; x + kStep <= x_end; x += kStep) {
+    const __m256i lo = SobelLanesU16Avx2(above, row, below, x);
+    const __m256i hi = SobelLanesU16Avx2(above, row, below, x + 8);
+    // packus works per 128-bit lane, so restore the pixel order afterwards.
+    const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x), packed);
+  }
+  SobelRowScalarOf(above, row, below, dst, x, x_end);
+}
+
+RYCHKOVA_D_SOBEL_TARGET("avx2")
+inline void SobelRowF32Avx2(const float *above, const float *row, const float *below, float *dst, std::size_t x_begin,
+                            std::size_t x_end) {
+  constexpr std::size_t kStep = 8;
+  const __m256 two = _mm256_set1_ps(2.0F);
+  const __m256 quarter = _mm256_set1_ps(0.25F);
+  const __m256 sign = _mm256_set1_ps(-0.0F);
+  std::size_t x = x_begin;
+  for (; x + kStep <= x_end; x += kStep) {
+    const __m256 a0 = _mm256_loadu_ps(above + x - 1);
+    const __m256 a1 = _mm256_loadu_ps(above + x);
+    const __m256 a2 = _mm256_loadu_ps(above + x + 1);
+    const __m256 r0 = _mm256_loadu_ps(row + x - 1);
+    const __m256 r2 = _mm256_loadu_ps(row + x + 1);
+    const __m256 b0 = _mm256_loadu_ps(below + x - 1);
+    const __m256 b1 = _mm256_loadu_ps(below + x);
+    const __m256 b2 = _mm256_loadu_ps(below + x + 1);
+
+    const __m256 gx = _mm256_add_ps(_mm256_add_ps(_mm256_sub_ps(a2, a0), _mm256_sub_ps(b2, b0)),
+                                    _mm256_mul_ps(two, _mm256_sub_ps(r2, r0)));
+    const __m256 gy = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(b0, b2), _mm256_mul_ps(two, b1)),
+                                    _mm256_add_ps(_mm256_add_ps(a0, a2), _mm256_mul_ps(two, a1)));
+    const __m256 mag = _mm256_add_ps(_mm256_andnot_ps(sign, gx), _mm256_andnot_ps(sign, gy));
+    _mm256_storeu_ps(dst + x, _mm256_mul_ps(mag, quarter));
+  }
+  SobelRowScalarOf(above, row, below, dst, x, x_end);
+}
+
+#endif  // RYCHKOVA_D_SOBEL_X86
+
+/// @brief Computes dst[x] for x in [x_begin, x_end) with the fastest kernel for @p Pixel the CPU supports.
+/// @details u8 goes to SobelRow; u16 and f32 use AVX2 where available (AVX-512 machines included).
+template <typename Pixel>
+void SobelRowOf(const Pixel *above, const Pixel *row, const Pixel *below, Pixel *dst, std::size_t x_begin,
+                std::size_t x_end) {
+  if constexpr (kIsU8Pixel<Pixel>) {
+    SobelRow(above, row, below, dst, x_begin, x_end);
+  } else {
+#ifdef RYCHKOVA_D_SOBEL_X86
+    if (ActiveSobelSimdLevel() >= SobelSimdLevel::kAvx2) {
+      if constexpr (std::is_same_v<Pixel, uint16_t>) {
+        SobelRowU16Avx2(above, row, below, dst, x_begin, x_end);
+      } else {
+        SobelRowF32Avx2(above, row, below, dst, x_begin, x_end);
+      }
+      return;
+    }
+#endif
+    SobelRowScalarOf(above, row, below, dst, x_begin, x_end);
+  }
+}
+
+/// @brief Converts pixels [begin, end) of @p img to grayscale into dst[begin, end), for any PixelLayout.
+/// @details u8 goes to the SIMD kernels of GrayPixels; wider types use SobelPixelTraits::Gray.
+template <typename Pixel>
+void GrayPixelsOf(const BasicImage<Pixel> &img, Pixel *dst, std::size_t begin, std::size_t end) {
+  if constexpr (kIsU8Pixel<Pixel>) {
+    GrayPixels(img, dst, begin, end);
+  } else {
+    // Element distance between consecutive pixels of a channel, and of the red, green and blue samples of a pixel.
+    const std::size_t step = img.layout == PixelLayout::kPlanar ? 1 : img.channels;
+    std::size_t r_at = 0;
+    std::size_t g_at = 1;
+    std::size_t b_at = 2;
+    if (img.layout == PixelLayout::kPlanar) {
+      g_at = img.width * img.height;
+      b_at = 2 * g_at;
+    } else if (img.layout == PixelLayout::kBgra) {
+      r_at = 2;
+      b_at = 0;
+    }
+    // Row segment by row segment, so strided images are read in place; planar images are always packed.
+    const bool packed = img.Packed();
+    for (std::size_t i = begin; i < end;) {
+      const std::size_t x = i % img.width;
+      const std::size_t n = packed ? end - i : std::min(end - i, img.width - x);
+      const Pixel *src = packed ? img.data.data() + (i * step) : img.Row(i / img.width) + (x * step);
+      if (img.channels == 1) {
+        std::copy(src, src + n, dst + i);
+      } else {
+        for (std::size_t k = 0; k < n; ++k) {
+          const Pixel *px = src + (k * step);
+          dst[i + k] = SobelPixelTraits<Pixel>::Gray(px[r_at], px[g_at], px[b_at]);
+        }
+      }
+      i += n;
+    }
+  }
+}
+
+/// @brief Computes dst[x] for x in [x_begin, x_end) of the output row whose @p Stencil window starts at @p top, with
+///        rows @p pitch apart; the 3x3 Sobel stencil goes to the SIMD kernels of SobelRowOf, the others to the
+///        unrolled StencilRow.
+template <typename Stencil, typename Pixel>
+void StencilRowOf(const Pixel *top, std::size_t pitch, Pixel *dst, std::size_t x_begin, std::size_t x_end) {
+  if constexpr (std::is_same_v<Stencil, Sobel3x3Stencil>) {
+    SobelRowOf(top, top + pitch, top + (2 * pitch), dst, x_begin, x_end);
+  } else {
+    StencilRow<Stencil, Pixel>(StencilWindowAt<Stencil>(top, pitch), dst, x_begin, x_end);
+  }
+}
+
+/// @brief Direct @p stencil over @p rows output rows of a gray frame, columns [radius, w - radius).
+/// @param src Top row of the window of the first output row, radius rows above it; @p dst first output row; both
+///            have stride @p w, which must be at least 2 * radius + 1.
+template <typename Pixel>
+void StencilGrayRowsOf(SobelStencil stencil, const Pixel *src, std::size_t w, std::size_t rows, Pixel *dst) {
+  VisitStencil(stencil, [&](auto s) {
+    using Stencil = decltype(s);
+    constexpr std::size_t kR = StencilTraits<Stencil>::kRadius;
+    for (std::size_t y = 0; y < rows; ++y) {
+      StencilRowOf<Stencil>(src + (y * w), w, dst + (y * w), kR, w - kR);
+    }
+  });
+}
+
+/// @brief Direct kernel over @p rows output rows of a gray window; the typed counterpart of SobelRows.
+/// @param src Row above the first output row; @p dst first output row; both have stride @p w.
+template <typename Pixel>
+void SobelGrayRowsOf(const Pixel *src, std::size_t w, std::size_t rows, Pixel *dst) {
+  for (std::size_t y = 0; y < rows; ++y) {
+    SobelRowOf(src + (y * w), src + ((y + 1) * w), src + ((y + 2) * w), dst + (y * w), 1, w - 1);
+  }
+}
+
+}  // namespace rychkova_d_sobel_edge_detection
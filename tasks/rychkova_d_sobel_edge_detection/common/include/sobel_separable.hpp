@@ -0,0 +1,190 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "rychkova_d_sobel_edge_detection/common/include/common.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_kernel.hpp"
+
+namespace rychkova_d_sobel_edge_detection {
+
+/// @brief Horizontal pass of the separable Sobel: [1 2 1] smoothing into @p s and [-1 0 1] difference into @p t.
+inline void SeparableHorizontalRow(const uint8_t *src_row, int16_t *s, int16_t *t, std::size_t w) {
+#pragma omp simd
+  for (std::size_t x = 1; x < w - 1; ++x) {
+    const auto left = static_cast<int16_t>(src_row[x - 1]);
+    const auto right = static_cast<int16_t>(src_row[x + 1]);
+    s[x] = static_cast<int16_t>(left + (2 * src_row[x]) + right);
+    t[x] = static_cast<int16_t>(right - left);
+  }
+}
+
+/// @brief Vertical pass of the separable Sobel: gx = t0 + 2 t1 + t2, gy = s2 - s0, then (|gx| + |gy|) / 4 clamped.
+inline void SeparableVerticalRow(const int16_t *s0, const int16_t *s2, const int16_t *t0, const int16_t *t1,
+                                 const int16_t *t2, uint8_t *dst_row, std::size_t w) {
+#pragma omp simd
+  for (std::size_t x = 1; x < w - 1; ++x) {
+    // Everything stays within int16_t: |gx| + |gy| <= 2040.
+    const auto gx = static_cast<int16_t>(t0[x] + (2 * t1[x]) + t2[x]);
+    const auto gy = static_cast<int16_t>(s2[x] - s0[x]);
+    const auto abs_gx = static_cast<int16_t>(gx < 0 ? -gx : gx);
+    const auto abs_gy = static_cast<int16_t>(gy < 0 ? -gy : gy);
+    const auto mag = static_cast<int16_t>((abs_gx + abs_gy) >> 2);
+    dst_row[x] = static_cast<uint8_t>(mag > 255 ? 255 : mag);
+  }
+}
+
+#ifdef RYCHKOVA_D_SOBEL_X86
+
+// Wider builds of the portable loops above; the compiler vectorizes the inlined bodies for the target ISA.
+
+RYCHKOVA_D_SOBEL_TARGET("avx2")
+inline void SeparableHorizontalRowAvx2(const uint8_t *src_row, int16_t *s, int16_t *t, std::size_t w) {
+  SeparableHorizontalRow(src_row, s, t, w);
+}
+
+RYCHKOVA_D_SOBEL_TARGET("avx2")
+inline void SeparableVerticalRowAvx2(const int16_t *s0, const int16_t *s2, const int16_t *t0, const int16_t *t1,
+                                     const int16_t *t2, uint8_t *dst_row, std::size_t w) {
+  SeparableVerticalRow(s0, s2, t0, t1, t2, dst_row, w);
+}
+
+RYCHKOVA_D_SOBEL_TARGET("avx512f,avx512bw")
+inline void SeparableHorizontalRowAvx512(const uint8_t *src_row, int16_t *s, int16_t *t, std::size_t w) {
+  SeparableHorizontalRow(src_row, s, t, w);
+}
+
+RYCHKOVA_D_SOBEL_TARGET("avx512f,avx512bw")
+inline void SeparableVerticalRowAvx512(const int16_t *s0, const int16_t *s2, const int16_t *t0, const int16_t *t1,
+                                       const int16_t *t2, uint8_t *dst_row, std::size_t w) {
+  SeparableVerticalRow(s0, s2, t0, t1, t2, dst_row, w);
+}
+
+#endif  // RYCHKOVA_D_SOBEL_X86
+
+/// @brief Separable Sobel evaluator that keeps horizontal partial sums of the last three rows in a ring.
+/// @details Each source row is filtered horizontally once into a smoothing ([1 2 1]) and a difference ([-1 0 1])
+///          row; every output row then only combines three cached rows vertically:
+///          gx = t[y-1] + 2 t[y] + t[y+1], gy = s[y+1] - s[y-1]. Results match the direct kernel bit for bit.
+class SobelSeparableRing {
+ public:
+  /// @brief Computes @p rows output rows of width @p w into @p dst.
+  /// @param src First of rows + 2 consecutive source rows (the row above the first output row), @p src_pitch apart;
+  ///            0 means w.
+  /// @param dst First output row; the first and last column of every row are set to zero.
+  void Process(const uint8_t *src, std::size_t w, std::size_t rows, uint8_t *dst, std::size_t src_pitch = 0) {
+    if (rows == 0 || w < 3) {
+      return;
+    }
+    const std::size_t pitch = src_pitch != 0 ? src_pitch : w;
+    Start(w);
+    Push(src);
+    Push(src + pitch);
+    for (std::size_t k = 0; k < rows; ++k) {
+      Push(src + ((k + 2) * pitch));
+      Emit(dst + (k * w));
+    }
+  }
+
+  /// @brief Begins a new stream of source rows of width @p w (w >= 3).
+  void Start(std::size_t w) {
+    if (smooth_.size() < kRingRows * w) {
+      smooth_.resize(kRingRows * w);
+      diff_.resize(kRingRows * w);
+    }
+    level_ = ActiveSobelSimdLevel();
+    width_ = w;
+    pushed_ = 0;
+  }
+
+  /// @brief Filters the next source row horizontally into the ring; the row itself is not retained.
+  void Push(const uint8_t *src_row) {
+    Horizontal(level_, src_row, width_, pushed_ % kRingRows);
+    ++pushed_;
+  }
+
+  /// @brief Writes the output row centred on the second to last pushed row; needs at least three pushes.
+  void Emit(uint8_t *dst_row) const {
+    const std::array<std::size_t, 3> slots = {pushed_ % kRingRows, (pushed_ + 1) % kRingRows,
+                                              (pushed_ + 2) % kRingRows};
+    Vertical(level_, width_, slots, dst_row);
+  }
+
+ private:
+  static constexpr std::size_t kRingRows = 3;
+
+  void Horizontal(SobelSimdLevel level, const uint8_t *src_row, std::size_t w, std::size_t slot) {
+    int16_t *s = smooth_.data() + (slot * w);
+    int16_t *t = diff_.data() + (slot * w);
+    switch (level) {
+#ifdef RYCHKOVA_D_SOBEL_X86
+      case SobelSimdLevel::kAvx512:
+        SeparableHorizontalRowAvx512(src_row, s, t, w);
+        return;
+      case SobelSimdLevel::kAvx2:
+        SeparableHorizontalRowAvx2(src_row, s, t, w);
+        return;
+#else
+      case SobelSimdLevel::kAvx512:
+      case SobelSimdLevel::kAvx2:
+#endif
+      case SobelSimdLevel::kSse2:
+      case SobelSimdLevel::kScalar:
+        SeparableHorizontalRow(src_row, s, t, w);
+        return;
+    }
+  }
+
+  void Vertical(SobelSimdLevel level, std::size_t w, const std::array<std::size_t, 3> &slots, uint8_t *dst_row) const {
+    const int16_t *s0 = smooth_.data() + (slots[0] * w);
+    const int16_t *s2 = smooth_.data() + (slots[2] * w);
+    const int16_t *t0 = diff_.data() + (slots[0] * w);
+    const int16_t *t1 = diff_.data() + (slots[1] * w);
+    const int16_t *t2 = diff_.data() + (slots[2] * w);
+
+    dst_row[0] = 0;
+    dst_row[w - 1] = 0;
+    switch (level) {
+#ifdef RYCHKOVA_D_SOBEL_X86
+      case SobelSimdLevel::kAvx512:
+        SeparableVerticalRowAvx512(s0, s2, t0, t1, t2, dst_row, w);
+        return;
+      case SobelSimdLevel::kAvx2:
+        SeparableVerticalRowAvx2(s0, s2, t0, t1, t2, dst_row, w);
+        return;
+#else
+      case SobelSimdLevel::kAvx512:
+      case SobelSimdLevel::kAvx2:
+#endif
+      case SobelSimdLevel::kSse2:
+      case SobelSimdLevel::kScalar:
+        SeparableVerticalRow(s0, s2, t0, t1, t2, dst_row, w);
+        return;
+    }
+  }
+
+  std::vector<int16_t> smooth_;
+  std::vector<int16_t> diff_;
+  SobelSimdLevel level_ = SobelSimdLevel::kScalar;
+  std::size_t width_ = 0;
+  std::size_t pushed_ = 0;
+};
+
+/// @brief Computes @p rows output rows from rows + 2 source rows starting at @p src with the selected kernel.
+/// @details Only the interior columns are written by the direct kernel; the separable pass also zeroes the borders.
+///          Source rows are @p src_pitch apart (0 means w); output rows are packed.
+inline void SobelRows(SobelKernelMode mode, SobelSeparableRing &ring, const uint8_t *src, std::size_t w,
+                      std::size_t rows, uint8_t *dst, std::size_t src_pitch = 0) {
+  if (mode == SobelKernelMode::kSeparable) {
+    ring.Process(src, w, rows, dst, src_pitch);
+    return;
+  }
+  const std::size_t pitch = src_pitch != 0 ? src_pitch : w;
+  for (std::size_t k = 0; k < rows; ++k) {
+    SobelRow(src + (k * pitch), src + ((k + 1) * pitch), src + ((k + 2) * pitch), dst + (k * w), 1, w - 1);
+  }
+}
+
+}  // namespace rychkova_d_sobel_edge_detection
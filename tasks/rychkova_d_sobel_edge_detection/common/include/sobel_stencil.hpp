@@ -0,0 +1,197 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+
+#include "rychkova_d_sobel_edge_detection/common/include/common.hpp"
+
+namespace rychkova_d_sobel_edge_detection {
+
+/// @brief Compile-time description of a pixel type of the typed Sobel pipeline.
+/// @details Acc holds gx, gy and |gx| + |gy| without overflow; Store divides |gx| + |gy| by the stencil norm and
+///          turns it into an output pixel, and Gray applies the (77 r + 150 g + 29 b) / 256 weights of the u8 path.
+template <typename Pixel>
+struct SobelPixelTraits;
+
+template <>
+struct SobelPixelTraits<uint8_t> {
+  using Acc = int;
+  template <int kNorm>
+  static uint8_t Store(Acc mag) {
+    return static_cast<uint8_t>(std::min(mag / kNorm, 255));
+  }
+  static uint8_t Gray(uint8_t r, uint8_t g, uint8_t b) {
+    return static_cast<uint8_t>((77 * r + 150 * g + 29 * b) >> 8);
+  }
+};
+
+/// 12- and 16-bit sensor data; |gx| + |gy| of the 5x5 stencil reaches 96 * 65535, so the sum needs 32 bits.
+template <>
+struct SobelPixelTraits<uint16_t> {
+  using Acc = int32_t;
+  template <int kNorm>
+  static uint16_t Store(Acc mag) {
+    return static_cast<uint16_t>(std::min<Acc>(mag / kNorm, 65535));
+  }
+  static uint16_t Gray(uint16_t r, uint16_t g, uint16_t b) {
+    return static_cast<uint16_t>(((77U * r) + (150U * g) + (29U * b)) >> 8);
+  }
+};
+
+/// Floating point data keeps its range: the magnitude is scaled by 1 / norm but never clamped.
+template <>
+struct SobelPixelTraits<float> {
+  using Acc = float;
+  template <int kNorm>
+  static float Store(Acc mag) {
+    return mag * (1.0F / static_cast<float>(kNorm));
+  }
+  static float Gray(float r, float g, float b) {
+    return ((77.0F * r) + (150.0F * g) + (29.0F * b)) * (1.0F / 256.0F);
+  }
+};
+
+// Coefficients of the separable gradient stencils: gx smooths down the columns with kSmooth and differentiates
+// along the rows with kDerive, gy the other way round. Taps run from -radius to +radius.
+
+struct Sobel3x3Stencil {
+  static constexpr std::array<int, 3> kSmooth = {1, 2, 1};
+  static constexpr std::array<int, 3> kDerive = {-1, 0, 1};
+};
+
+struct Scharr3x3Stencil {
+  static constexpr std::array<int, 3> kSmooth = {3, 10, 3};
+  static constexpr std::array<int, 3> kDerive = {-1, 0, 1};
+};
+
+struct Prewitt3x3Stencil {
+  static constexpr std::array<int, 3> kSmooth = {1, 1, 1};
+  static constexpr std::array<int, 3> kDerive = {-1, 0, 1};
+};
+
+struct Sobel5x5Stencil {
+  static constexpr std::array<int, 5> kSmooth = {1, 4, 6, 4, 1};
+  static constexpr std::array<int, 5> kDerive = {-1, -2, 0, 2, 1};
+};
+
+/// @brief Extent and normalization of @p Stencil, checked at compile time.
+/// @details kNorm is the sum of the smoothing weights times the sum of the positive derivative weights, so a step of
+///          height v across the stencil gives a magnitude of v per axis; it is 4 for the 3x3 Sobel stencil.
+template <typename Stencil>
+struct StencilTraits {
+  static constexpr std::size_t kTaps = Stencil::kSmooth.size();
+  static constexpr std::size_t kRadius = kTaps / 2;
+  static constexpr int kNorm = [] {
+    int smooth = 0;
+    int derive = 0;
+    for (std::size_t k = 0; k < kTaps; ++k) {
+      smooth += Stencil::kSmooth[k];
+      derive += std::max(Stencil::kDerive[k], 0);
+    }
+    return smooth * derive;
+  }();
+
+  // The engine pairs the taps at -k and +k before weighting them, which needs these symmetries.
+  static_assert(kTaps % 2 == 1 && Stencil::kDerive.size() == kTaps, "stencil taps must be odd and of equal count");
+  static_assert(
+      [] {
+        for (std::size_t k = 0; k < kTaps; ++k) {
+          if (Stencil::kSmooth[k] != Stencil::kSmooth[kTaps - 1 - k] ||
+              Stencil::kDerive[k] != -Stencil::kDerive[kTaps - 1 - k]) {
+            return false;
+          }
+        }
+        return true;
+      }(),
+      "smoothing taps must be symmetric and derivative taps antisymmetric");
+  static_assert(kNorm > 0, "stencil must have positive smoothing and derivative weights");
+};
+
+/// @brief The 2 * radius + 1 source rows around one output row of @p Stencil, top row first.
+template <typename Stencil, typename Pixel>
+using StencilWindow = std::array<const Pixel *, StencilTraits<Stencil>::kTaps>;
+
+/// @brief Window of the rows of pitch @p pitch starting at @p top.
+template <typename Stencil, typename Pixel>
+StencilWindow<Stencil, Pixel> StencilWindowAt(const Pixel *top, std::size_t pitch) {
+  return [&]<std::size_t... K>(std::index_sequence<K...> /*unused*/) {
+    return StencilWindow<Stencil, Pixel>{(top + (K * pitch))...};
+  }(std::make_index_sequence<StencilTraits<Stencil>::kTaps>{});
+}
+
+/// @brief Gradient magnitude of pixel @p x under @p Stencil: (|gx| + |gy|) / kNorm, stored by SobelPixelTraits.
+/// @details Every tap loop is a fold over the compile-time radius, so the stencil is fully unrolled with constant
+///          weights. Taps at -k and +k are paired before they are weighted and the centre tap comes last, which is
+///          the operation order of the hand-written 3x3 Sobel SIMD kernels, so float results match them bit for bit.
+template <typename Stencil, typename Pixel>
+Pixel StencilPixel(const StencilWindow<Stencil, Pixel> &rows, std::size_t x) {
+  using Traits = StencilTraits<Stencil>;
+  using Acc = typename SobelPixelTraits<Pixel>::Acc;
+  constexpr std::size_t kR = Traits::kRadius;
+  constexpr auto kPairs = std::make_index_sequence<kR>{};
+  const auto weight = [](int coefficient) { return static_cast<Acc>(coefficient); };
+  const auto left = [x](const Pixel *row, std::size_t d) { return static_cast<Acc>(row[x - d]); };
+  const auto right = [x](const Pixel *row, std::size_t d) { return static_cast<Acc>(row[x + d]); };
+
+  // Derivative and smoothing of one row around x; K + 1 is the distance of a tap pair from the centre.
+  const auto derive = [&]<std::size_t... K>(const Pixel *row, std::index_sequence<K...> /*unused*/) {
+    return (Acc{} + ... + (weight(Stencil::kDerive[kR + 1 + K]) * (right(row, K + 1) - left(row, K + 1))));
+  };
+  const auto smooth = [&]<std::size_t... K>(const Pixel *row, std::index_sequence<K...> /*unused*/) {
+    return (Acc{} + ... + (weight(Stencil::kSmooth[kR - 1 - K]) * (left(row, K + 1) + right(row, K + 1)))) +
+           (weight(Stencil::kSmooth[kR]) * right(row, 0));
+  };
+
+  const Acc gx = [&]<std::size_t... K>(std::index_sequence<K...> pairs) {
+    return (Acc{} + ... +
+            (weight(Stencil::kSmooth[kR - 1 - K]) *
+             (derive(rows[kR - 1 - K], pairs) + derive(rows[kR + 1 + K], pairs)))) +
+           (weight(Stencil::kSmooth[kR]) * derive(rows[kR], pairs));
+  }(kPairs);
+  const Acc gy = [&]<std::size_t... K>(std::index_sequence<K...> pairs) {
+    return (Acc{} + ... +
+            (weight(Stencil::kDerive[kR + 1 + K]) *
+             (smooth(rows[kR + 1 + K], pairs) - smooth(rows[kR - 1 - K], pairs))));
+  }(kPairs);
+
+  return SobelPixelTraits<Pixel>::template Store<Traits::kNorm>(std::abs(gx) + std::abs(gy));
+}
+
+/// @brief Computes dst[x] for x in [x_begin, x_end) with the unrolled @p Stencil; a plain loop the compiler
+///        vectorizes.
+/// @details Requires radius <= x_begin and x_end + radius <= row width.
+template <typename Stencil, typename Pixel>
+void StencilRow(const StencilWindow<Stencil, Pixel> &rows, Pixel *dst, std::size_t x_begin, std::size_t x_end) {
+  for (std::size_t x = x_begin; x < x_end; ++x) {
+    dst[x] = StencilPixel<Stencil, Pixel>(rows, x);
+  }
+}
+
+/// @brief Calls @p fn with a value of the compile-time stencil type that @p stencil selects, so a frame loop is
+///        instantiated once per stencil and the choice is made once per call rather than once per pixel.
+template <typename Fn>
+decltype(auto) VisitStencil(SobelStencil stencil, Fn &&fn) {
+  switch (stencil) {
+    case SobelStencil::kScharr:
+      return fn(Scharr3x3Stencil{});
+    case SobelStencil::kPrewitt:
+      return fn(Prewitt3x3Stencil{});
+    case SobelStencil::kSobel5x5:
+      return fn(Sobel5x5Stencil{});
+    case SobelStencil::kSobel:
+      break;
+  }
+  return fn(Sobel3x3Stencil{});
+}
+
+/// @brief Rows and columns along each image edge that @p stencil leaves at zero: 1 for the 3x3 stencils, 2 for 5x5.
+inline std::size_t StencilRadius(SobelStencil stencil) {
+  return VisitStencil(stencil, [](auto s) { return StencilTraits<decltype(s)>::kRadius; });
+}
+
+}  // namespace rychkova_d_sobel_edge_detection
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "rychkova_d_sobel_edge_detection/common/include/common.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_pixel.hpp"
+
+namespace rychkova_d_sobel_edge_detection {
+
+/// @brief Half-open block of output pixels [y_begin, y_end) x [x_begin, x_end).
+struct SobelTile {
+  std::size_t y_begin = 0;
+  std::size_t y_end = 0;
+  std::size_t x_begin = 0;
+  std::size_t x_end = 0;
+};
+
+/// @brief Partition of @p rows output rows times the interior columns [1, w - 1) into cache-sized tiles.
+/// @details Tiles are numbered row-major, so consecutive indices walk across one band of rows before the next
+///          band starts; the last tile of every band and every column may be smaller than the nominal size.
+class SobelTileGrid {
+ public:
+  SobelTileGrid(std::size_t w, std::size_t rows, const SobelOptions &options)
+      : rows_(rows),
+        x_end_(w - 1),
+        tile_w_(options.tile_width),
+        tile_h_(options.tile_height),
+        tiles_x_(CeilDiv(w - 2, tile_w_)),
+        tiles_y_(CeilDiv(rows, tile_h_)) {}
+
+  [[nodiscard]] std::size_t Count() const {
+    return tiles_x_ * tiles_y_;
+  }
+
+  [[nodiscard]] SobelTile Tile(std::size_t index) const {
+    const std::size_t ty = index / tiles_x_;
+    const std::size_t tx = index % tiles_x_;
+    SobelTile tile;
+    tile.y_begin = ty * tile_h_;
+    tile.y_end = std::min(tile.y_begin + tile_h_, rows_);
+    tile.x_begin = 1 + (tx * tile_w_);
+    tile.x_end = std::min(tile.x_begin + tile_w_, x_end_);
+    return tile;
+  }
+
+ private:
+  static std::size_t CeilDiv(std::size_t a, std::size_t b) {
+    return (a + b - 1) / b;
+  }
+
+  std::size_t rows_;
+  std::size_t x_end_;
+  std::size_t tile_w_;
+  std::size_t tile_h_;
+  std::size_t tiles_x_;
+  std::size_t tiles_y_;
+};
+
+/// @brief Checks that the tile extents are usable for SobelTraversal::kTiles.
+inline bool ValidTiling(const SobelOptions &options) {
+  return options.traversal == SobelTraversal::kRows || (options.tile_width > 0 && options.tile_height > 0);
+}
+
+/// @brief Computes one tile with the direct kernel.
+/// @details As with SobelRows, @p src is the row above output row 0, so output row y reads source rows y .. y + 2;
+///          both buffers have stride @p w.
+template <typename Pixel>
+void SobelTileRows(const Pixel *src, Pixel *dst, std::size_t w, const SobelTile &tile) {
+  for (std::size_t y = tile.y_begin; y < tile.y_end; ++y) {
+    SobelRowOf(src + (y * w), src + ((y + 1) * w), src + ((y + 2) * w), dst + (y * w), tile.x_begin, tile.x_end);
+  }
+}
+
+}  // namespace rychkova_d_sobel_edge_detection
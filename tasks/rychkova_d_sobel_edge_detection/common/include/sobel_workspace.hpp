@@ -0,0 +1,76 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "rychkova_d_sobel_edge_detection/common/include/common.hpp"
+
+namespace rychkova_d_sobel_edge_detection {
+
+/// @brief Zeroes the pixels of image rows [start, start + rows), held at @p strip, that lie within @p radius of the
+///        border of the w x h image: the first and last @p radius columns, and whole rows near the top and bottom.
+/// @details The kernels write the interior only, so this is all a reused output buffer needs before the next run.
+template <typename Pixel>
+void ZeroStripBorder(Pixel *strip, std::size_t w, std::size_t start, std::size_t rows, std::size_t h,
+                     std::size_t radius = 1) {
+  if (w == 0 || rows == 0) {
+    return;
+  }
+  const std::size_t cols = std::min(radius, w);
+  for (std::size_t y = 0; y < rows; ++y) {
+    std::fill_n(strip + (y * w), cols, Pixel{});
+    std::fill_n(strip + (y * w) + w - cols, cols, Pixel{});
+  }
+  const std::size_t top_end = std::min(rows, radius > start ? radius - start : 0);
+  std::fill_n(strip, top_end * w, Pixel{});
+  const std::size_t bottom_begin = std::max(start, h > radius ? h - radius : 0) - start;
+  if (bottom_begin < rows) {
+    std::fill_n(strip + (bottom_begin * w), (rows - bottom_begin) * w, Pixel{});
+  }
+}
+
+/// @brief ZeroStripBorder over a whole w x h frame.
+template <typename Pixel>
+void ZeroBorder(Pixel *frame, std::size_t w, std::size_t h, std::size_t radius = 1) {
+  ZeroStripBorder(frame, w, 0, h, h, radius);
+}
+
+/// @brief Frame buffers a Sobel task keeps from pipeline run to pipeline run.
+/// @details Buffers are resized, never reassigned, so they only grow: a run over an image no larger than an earlier
+///          one allocates nothing and clears only the output border. The output frame is lent to the task output by
+///          PostProcessing and taken back by the next PreProcessing.
+template <typename Pixel>
+struct BasicSobelWorkspace {
+  PixelBuffer<Pixel> gray;
+  PixelBuffer<Pixel> out;
+
+  /// @brief Sizes the gray frame to @p pixels; the contents are left for the conversion to overwrite.
+  Pixel *PrepareGray(std::size_t pixels) {
+    gray.resize(pixels);
+    return gray.data();
+  }
+
+  /// @brief Takes back the buffer lent to @p lent and sizes the output frame to w x h with a zero border of
+  ///        @p radius pixels; the interior is left for Run to overwrite.
+  Pixel *PrepareOut(PixelBuffer<Pixel> &lent, std::size_t w, std::size_t h, std::size_t radius = 1) {
+    if (lent.capacity() > out.capacity()) {
+      out.swap(lent);
+    }
+    lent.clear();
+    out.resize(w * h);
+    ZeroBorder(out.data(), w, h, radius);
+    return out.data();
+  }
+
+  /// @brief Moves the output frame into @p dst, usually the data of the task output.
+  void LendOut(PixelBuffer<Pixel> &dst) {
+    dst = std::move(out);
+    out.clear();
+  }
+};
+
+using SobelWorkspace = BasicSobelWorkspace<uint8_t>;
+
+}  // namespace rychkova_d_sobel_edge_detection
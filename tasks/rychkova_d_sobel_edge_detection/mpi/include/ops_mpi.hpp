@@ -1,17 +1,148 @@
 #pragma once
 
+#include <mpi.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
 #include "rychkova_d_sobel_edge_detection/common/include/common.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_fused.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_separable.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_stencil.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_workspace.hpp"
 #include "task/include/task.hpp"
 
 namespace rychkova_d_sobel_edge_detection {
 
+/// @brief Image rows owned by one MPI rank plus the halo rows its stencil needs from the neighbours.
+struct RowStrip {
+  std::size_t start = 0;
+  std::size_t rows = 0;
+  std::size_t halo_top = 0;
+  std::size_t halo_bottom = 0;
+
+  /// @brief Number of rows the rank holds, halo rows included.
+  [[nodiscard]] std::size_t RecvRows() const {
+    return rows + halo_top + halo_bottom;
+  }
+
+  /// @brief Rows [begin, end) of the held strip (halo rows counted) that belong to piece @p k of @p pieces.
+  [[nodiscard]] std::pair<std::size_t, std::size_t> Piece(std::size_t k, std::size_t pieces) const {
+    return {RecvRows() * k / pieces, RecvRows() * (k + 1) / pieces};
+  }
+
+  /// @brief Owned output rows [begin, end) that become computable once pieces 0 .. @p k have arrived.
+  [[nodiscard]] std::pair<std::size_t, std::size_t> PieceOutput(std::size_t k, std::size_t pieces) const {
+    return {k == 0 ? 0 : ReadyRows(k - 1, pieces), ReadyRows(k, pieces)};
+  }
+
+ private:
+  [[nodiscard]] std::size_t ReadyRows(std::size_t k, std::size_t pieces) const {
+    if (k + 1 == pieces) {
+      return rows;
+    }
+    // Output row y needs held rows up to y + halo_top + 1.
+    const std::size_t arrived = Piece(k, pieces).second;
+    return arrived > halo_top + 1 ? std::min(rows, arrived - halo_top - 1) : 0;
+  }
+};
+
+/// @brief Balanced split of @p h rows over @p size ranks; the first h % size ranks get one row more.
+/// @details Halos hold up to @p radius rows, the stencil radius, on each side that has rows.
+inline RowStrip StripOf(std::size_t rank, std::size_t size, std::size_t h, std::size_t radius = 1) {
+  const std::size_t base = h / size;
+  const std::size_t rem = h % size;
+
+  RowStrip strip;
+  strip.rows = base + (rank < rem ? 1 : 0);
+  strip.start = (base * rank) + std::min(rank, rem);
+  // Ranks left without rows (more ranks than rows) need no halos either.
+  strip.halo_top = strip.rows > 0 ? std::min(radius, strip.start) : 0;
+  strip.halo_bottom = strip.rows > 0 ? std::min(radius, h - strip.start - strip.rows) : 0;
+  return strip;
+}
+
+/// @brief Shape of the MPI process grid; cols == 1 is the row strip decomposition.
+struct ProcessGrid {
+  int rows = 1;
+  int cols = 1;
+};
+
+/// @brief Rows and columns owned by one rank of the Cartesian grid; both axes use the balanced split of StripOf.
+struct BlockExtent {
+  std::size_t row_start = 0;
+  std::size_t rows = 0;
+  std::size_t col_start = 0;
+  std::size_t cols = 0;
+};
+
+/// @brief Cartesian communicator, block, neighbours and halo datatypes of SobelDecomposition::kBlocks.
+/// @details Gray and output blocks carry one halo column and row on each side, so their pitch is cols + 2.
+struct BlockPlan {
+  MPI_Comm cart = MPI_COMM_NULL;
+  BlockExtent extent;
+  int left = MPI_PROC_NULL;
+  int right = MPI_PROC_NULL;
+  int up = MPI_PROC_NULL;
+  int down = MPI_PROC_NULL;
+  MPI_Datatype column = MPI_DATATYPE_NULL;      // one interior column of the padded gray block
+  MPI_Datatype padded_row = MPI_DATATYPE_NULL;  // one full padded gray row, so the corners travel with it
+  MPI_Datatype out_block = MPI_DATATYPE_NULL;   // interior of the padded output block
+  std::vector<MPI_Datatype> root_types;         // on rank 0: the input and output block of every rank in the frame
+};
+
+/// @brief Rows of the full image that a rank's output holds under SobelOutputMode::kDistributed.
+struct OutputStrip {
+  std::size_t row_start = 0;
+  std::size_t rows = 0;
+  std::size_t width = 0;
+  std::size_t height = 0;
+};
+
+/// @brief Node communicators and the shared memory window of SobelTransport::kSharedWindow.
+struct SharedNode {
+  MPI_Comm node = MPI_COMM_NULL;
+  MPI_Comm leaders = MPI_COMM_NULL;  // one rank per node; MPI_COMM_NULL on the other ranks
+  MPI_Win win = MPI_WIN_NULL;
+  int node_rank = 0;
+  int node_size = 1;
+  std::size_t nodes = 1;
+  RowStrip node_strip;
+  // Raw, gray and output rows of the node strip inside the window.
+  uint8_t *raw = nullptr;
+  uint8_t *gray = nullptr;
+  uint8_t *out = nullptr;
+};
+
 class SobelEdgeDetectionMPI : public BaseTask {
  public:
   static constexpr ppc::task::TypeOfTask GetStaticTypeOfTask() {
     return ppc::task::TypeOfTask::kMPI;
   }
 
-  explicit SobelEdgeDetectionMPI(const InType &in);
+  explicit SobelEdgeDetectionMPI(InType in, SobelOptions options = {});
+  SobelEdgeDetectionMPI(const SobelEdgeDetectionMPI &) = delete;
+  SobelEdgeDetectionMPI &operator=(const SobelEdgeDetectionMPI &) = delete;
+  SobelEdgeDetectionMPI(SobelEdgeDetectionMPI &&) = delete;
+  SobelEdgeDetectionMPI &operator=(SobelEdgeDetectionMPI &&) = delete;
+  ~SobelEdgeDetectionMPI() override;
+
+  /// @brief Position of this rank's output rows in the full image; valid after Run.
+  [[nodiscard]] const OutputStrip &GetOutputStrip() const {
+    return output_strip_;
+  }
+
+  /// @brief Collective; assembles the distributed output strips into the output of rank 0.
+  /// @details Call once, after PostProcessing; other ranks keep their strips. No-op for SobelOutputMode::kGathered.
+  bool GatherOutput();
+
+  /// @brief Collective; frees the transfer plan that runs keep from one to the next, the shared window included.
+  /// @details Optional: PreProcessing replaces a stale plan itself, and MPI_Finalize reclaims a window left behind.
+  void ReleaseTransfers();
 
  private:
   bool ValidationImpl() override;
@@ -19,8 +150,78 @@ class SobelEdgeDetectionMPI : public BaseTask {
   bool RunImpl() override;
   bool PostProcessingImpl() override;
 
-  std::vector<uint8_t> gray_;
-  std::vector<uint8_t> out_data_;
+  /// @brief Pipelined variant of Run: nonblocking scatter and gather pieces overlap with the computation.
+  bool RunOverlapped(int rank, int size, std::size_t w, std::size_t h, std::size_t ch);
+  /// @brief Variant of Run for 2D blocks on a Cartesian process grid with gray row/column halo exchange.
+  bool RunBlocks(std::size_t w, std::size_t h, std::size_t ch);
+  /// @brief Sizes the strip or block buffers of this rank and zeroes the parts no run overwrites; allocates only
+  ///        when they grow.
+  void PrepareBuffers(int rank, int size);
+  /// @brief Builds the persistent requests of the blocking row strip path.
+  void PlanStrips(int rank, int size);
+  /// @brief Builds the piece counts, row datatypes and request slots of SobelCommMode::kOverlapped.
+  void PlanOverlapped(int rank, int size);
+  /// @brief Builds the Cartesian communicator, block datatypes and persistent requests of the blocks.
+  void PlanBlocks(int rank);
+  /// @brief Splits the node communicators and allocates the shared memory window of SobelTransport::kSharedWindow.
+  void PlanShared(int rank);
+  /// @brief Frees what the Plan functions set up; collective over the ranks that planned a shared window.
+  void ReleasePlan();
+  /// @brief The part of ReleasePlan that needs no peers: requests, datatypes and the Cartesian communicator.
+  void ReleaseLocalPlan();
+  /// @brief Variant of Run that shares one node strip per node through an MPI shared memory window.
+  bool RunShared(int rank);
+  [[nodiscard]] ProcessGrid PickProcessGrid(int size, std::size_t w, std::size_t h) const;
+  /// @brief Filters the owned output rows [y_lo, y_hi) of @p strip, skipping the image border rows.
+  /// @param src_strip Held rows of the strip, halo rows first; gray when @p src_channels is 1, otherwise raw
+  ///                  interleaved pixels that are converted on the fly.
+  void FilterRows(const uint8_t *src_strip, std::size_t src_channels, std::size_t w, const RowStrip &strip,
+                  std::size_t h, std::size_t y_lo, std::size_t y_hi, uint8_t *local_out);
+  [[nodiscard]] bool Fused() const;
+  /// @brief Pixels rank 0 sends out: the input, or its gray frame when the input is not packed and interleaved.
+  [[nodiscard]] const uint8_t *RootPixels() {
+    return workspace_.gray.empty() ? GetInput().data.data() : workspace_.gray.data();
+  }
+
+  // Image geometry and decomposition, broadcast and planned once in PreProcessing.
+  std::size_t width_ = 0;
+  std::size_t height_ = 0;
+  std::size_t channels_ = 1;
+  // StencilRadius of the stencil option: halo rows per strip side and zero border width.
+  std::size_t radius_ = 1;
+  ProcessGrid grid_;
+  // Geometry and buffer addresses the current plan was built for; PreProcessing replans only when they change.
+  bool planned_ = false;
+  std::array<std::size_t, 3> planned_dims_ = {0, 0, 0};
+  std::array<const void *, 5> planned_buffers_ = {};
+  // Raw strip (halo rows included) or block the scatter receives into.
+  PixelBuffer<uint8_t> src_chunk_;
+  MPI_Datatype in_row_ = MPI_DATATYPE_NULL;
+  MPI_Datatype out_row_ = MPI_DATATYPE_NULL;
+  std::vector<MPI_Request> scatter_requests_;
+  std::vector<MPI_Request> gather_requests_;
+  BlockPlan blocks_;
+  SharedNode shared_;
+  // On rank 0: the gathered output, and the gray frame of a planar, RGBA, BGRA or strided input (the strips of the
+  // others hold raw input rows).
+  SobelWorkspace workspace_;
+
+  // Every buffer below keeps its capacity from run to run, so repeated runs over one geometry do not allocate.
+  // Grayscale copy of this rank's strip, halo rows included; unused for single-channel and fused runs.
+  PixelBuffer<uint8_t> gray_;
+  // Output rows of this rank; lent to the output under SobelOutputMode::kDistributed.
+  PixelBuffer<uint8_t> local_out_;
+  // Counts and displacements of the root's collectives, and the request slots of the overlapped pieces.
+  std::vector<int> sendcounts_;
+  std::vector<int> displs_;
+  std::vector<int> recvcounts_;
+  std::vector<int> recv_displs_;
+  std::vector<MPI_Request> piece_scatters_;
+  std::vector<MPI_Request> piece_gathers_;
+  OutputStrip output_strip_;
+  SobelOptions options_;
+  SobelSeparableRing separable_;
+  SobelFusedWindow fused_;
 };
 
 }  // namespace rychkova_d_sobel_edge_detection
@@ -3,40 +3,153 @@
 #include <mpi.h>
 
 #include <algorithm>
-#include <cmath>
+#include <array>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <numeric>
+#include <utility>
 #include <vector>
 
 #include "rychkova_d_sobel_edge_detection/common/include/common.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_fused.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_gray.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_pixel.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_separable.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_stencil.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_tiles.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_workspace.hpp"
 
 namespace rychkova_d_sobel_edge_detection {
 
 namespace {
 
-inline uint8_t ClampToU8(int v) {
-  if (v < 0) {
-    return 0;
-  }
-  if (v > 255) {
-    return 255;
+// Point-to-point message tags of the strip and block transfers; halo exchanges use kTagHalo .. kTagHalo + 3.
+constexpr int kTagScatter = 0;
+constexpr int kTagHalo = 1;
+constexpr int kTagGather = 5;
+
+// Swaps boundary rows with the neighbouring ranks: the first owned row goes up while the bottom halo arrives from
+// below, then the last owned row goes down while the top halo arrives from above. MPI_PROC_NULL marks a missing
+// neighbour at the image edge.
+void ExchangeHaloRows(uint8_t *strip, std::size_t row_len, std::size_t local_rows, std::size_t halo_top, int up,
+                      int down) {
+  const auto count = static_cast<int>(row_len);
+  uint8_t *first_owned = strip + (halo_top * row_len);
+  uint8_t *last_owned = strip + ((halo_top + local_rows - 1) * row_len);
+  uint8_t *top_halo = strip;
+  uint8_t *bottom_halo = last_owned + row_len;
+
+  MPI_Sendrecv(first_owned, count, MPI_UNSIGNED_CHAR, up, kTagHalo, bottom_halo, count, MPI_UNSIGNED_CHAR, down,
+               kTagHalo, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+  MPI_Sendrecv(last_owned, count, MPI_UNSIGNED_CHAR, down, kTagHalo + 1, top_halo, count, MPI_UNSIGNED_CHAR, up,
+               kTagHalo + 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+}
+
+// Contiguous datatype for one image row of @p row_bytes bytes. Collectives count and displace in rows with it, so
+// frames of many GiB stay far below the int limits of MPI counts; the caller frees the type.
+MPI_Datatype MakeRowType(std::size_t row_bytes) {
+  MPI_Datatype row_type = MPI_DATATYPE_NULL;
+  MPI_Type_contiguous(static_cast<int>(row_bytes), MPI_UNSIGNED_CHAR, &row_type);
+  MPI_Type_commit(&row_type);
+  return row_type;
+}
+
+// Starts a set of persistent requests and waits for all of them; Open MPI rejects the null array of an empty set.
+void StartAndWait(std::vector<MPI_Request> &requests) {
+  if (requests.empty()) {
+    return;
   }
-  return static_cast<uint8_t>(v);
+  MPI_Startall(static_cast<int>(requests.size()), requests.data());
+  MPI_Waitall(static_cast<int>(requests.size()), requests.data(), MPI_STATUSES_IGNORE);
+}
+
+// Options that only the row strip decomposition implements; auto mode keeps strips when any of them is set.
+bool UsesStripOnlyOptions(const SobelOptions &options) {
+  return options.stencil != SobelStencil::kSobel || options.kernel != SobelKernelMode::kDirect ||
+         options.gray != SobelGrayMode::kFrame || options.traversal != SobelTraversal::kRows ||
+         options.halo != SobelHaloMode::kScatter || options.comm != SobelCommMode::kBlocking ||
+         options.transport != SobelTransport::kMessages || options.output != SobelOutputMode::kGathered;
+}
+
+// Cartesian ranks are numbered row-major, as MPI_Cart_create lays them out without reordering, so the block of a
+// rank is known before the communicator exists.
+BlockExtent BlockOf(int rank, ProcessGrid grid, std::size_t w, std::size_t h) {
+  const auto grid_rows = static_cast<std::size_t>(grid.rows);
+  const auto grid_cols = static_cast<std::size_t>(grid.cols);
+  const auto index = static_cast<std::size_t>(rank);
+  const RowStrip rows = StripOf(index / grid_cols, grid_rows, h);
+  const RowStrip cols = StripOf(index % grid_cols, grid_cols, w);
+  return BlockExtent{.row_start = rows.start, .rows = rows.rows, .col_start = cols.start, .cols = cols.rows};
+}
+
+// Strided vector of @p count blocks of @p block_bytes bytes, @p stride bytes apart; the caller frees the type.
+MPI_Datatype MakeBlockType(std::size_t count, std::size_t block_bytes, std::size_t stride) {
+  MPI_Datatype type = MPI_DATATYPE_NULL;
+  MPI_Type_vector(static_cast<int>(count), static_cast<int>(block_bytes), static_cast<int>(stride), MPI_UNSIGNED_CHAR,
+                  &type);
+  MPI_Type_commit(&type);
+  return type;
+}
+
+// Makes the stores of every rank of @p node into the shared window visible to all of them (MPI-3 unified model:
+// memory barrier, process barrier, memory barrier).
+void SyncNode(MPI_Win win, MPI_Comm node) {
+  MPI_Win_sync(win);
+  MPI_Barrier(node);
+  MPI_Win_sync(win);
 }
 
 }  // namespace
 
-SobelEdgeDetectionMPI::SobelEdgeDetectionMPI(const InType &in) {
+SobelEdgeDetectionMPI::SobelEdgeDetectionMPI(InType in, SobelOptions options) : options_(options) {
   SetTypeOfTask(GetStaticTypeOfTask());
-  GetInput() = in;
+  GetInput() = std::move(in);
   GetOutput() = OutType{};
 }
 
+SobelEdgeDetectionMPI::~SobelEdgeDetectionMPI() {
+  // The plan outlives PostProcessing so the next run can reuse it; free the handles that need no peers. A shared
+  // window and its node communicators (collective to free) are left to MPI_Finalize unless ReleaseTransfers freed
+  // them.
+  int finalized = 0;
+  MPI_Finalized(&finalized);
+  if (finalized == 0) {
+    ReleaseLocalPlan();
+  }
+}
+
 bool SobelEdgeDetectionMPI::ValidationImpl() {
   int rank = 0;
   MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 
+  // Every rank holds the same options, so every rank rejects a bad combination and none enters PreProcessing alone.
+  if (!ValidTiling(options_)) {
+    return false;
+  }
+  if (options_.comm == SobelCommMode::kOverlapped &&
+      (options_.comm_blocks == 0 || options_.halo == SobelHaloMode::kExchange)) {
+    return false;
+  }
+  if (options_.decomposition == SobelDecomposition::kBlocks &&
+      (options_.halo == SobelHaloMode::kExchange || options_.comm == SobelCommMode::kOverlapped)) {
+    return false;
+  }
+  if (options_.transport == SobelTransport::kSharedWindow &&
+      (options_.halo == SobelHaloMode::kExchange || options_.comm == SobelCommMode::kOverlapped ||
+       options_.decomposition == SobelDecomposition::kBlocks)) {
+    return false;
+  }
+  if (options_.output == SobelOutputMode::kDistributed && options_.decomposition == SobelDecomposition::kBlocks) {
+    return false;
+  }
+  // Only the blocking scattered row strips carry halos wider than one row.
+  if (options_.stencil != SobelStencil::kSobel &&
+      (options_.halo == SobelHaloMode::kExchange || options_.comm == SobelCommMode::kOverlapped ||
+       options_.transport == SobelTransport::kSharedWindow || options_.decomposition == SobelDecomposition::kBlocks)) {
+    return false;
+  }
+
   if (rank != 0) {
     return true;
   }
@@ -45,12 +158,15 @@ bool SobelEdgeDetectionMPI::ValidationImpl() {
   if (in.width == 0 || in.height == 0) {
     return false;
   }
-  if (in.channels != 1 && in.channels != 3) {
+  if (!ValidPixelFormat(in.channels, in.layout)) {
     return false;
   }
-
-  const std::size_t expected = in.width * in.height * in.channels;
-  if (in.data.size() != expected) {
+  if (!ValidImageBuffer(in)) {
+    return false;
+  }
+  // Rows are the unit of every MPI count, so a single row and the number of rows must fit into an int.
+  constexpr auto kMaxCount = static_cast<std::size_t>(std::numeric_limits<int>::max());
+  if (in.width * in.channels > kMaxCount || in.height > kMaxCount) {
     return false;
   }
 
@@ -60,188 +176,739 @@ bool SobelEdgeDetectionMPI::ValidationImpl() {
 
 bool SobelEdgeDetectionMPI::PreProcessingImpl() {
   int rank = 0;
+  int size = 1;
   MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
 
+  std::array<std::size_t, 3> dims = {0, 0, 1};
   if (rank == 0) {
     const auto &in = GetInput();
     auto &out = GetOutput();
     out.width = in.width;
     out.height = in.height;
     out.channels = 1;
+
+    // Distributed output never assembles the full image, so the root does not allocate it either.
+    if (options_.output == SobelOutputMode::kGathered) {
+      workspace_.PrepareOut(out.data, in.width, in.height, StencilRadius(options_.stencil));
+    }
+    // Planar, four-channel and strided images are converted to gray here once; the ranks then filter packed
+    // single-channel rows.
+    dims = {in.width, in.height, in.channels};
+    workspace_.gray.clear();
+    if (in.layout != PixelLayout::kInterleaved || !in.Packed()) {
+      const std::size_t pixels = in.width * in.height;
+      GrayPixels(in, workspace_.PrepareGray(pixels), 0, pixels);
+      dims[2] = 1;
+    }
+  }
+  if (options_.output == SobelOutputMode::kDistributed) {
+    // Every rank takes back the strip it lent to its output in the previous run.
+    auto &out = GetOutput();
+    if (out.data.capacity() > local_out_.capacity()) {
+      local_out_.swap(out.data);
+    }
     out.data.clear();
+  }
 
-    out_data_.assign(in.width * in.height, 0);
+  // The decomposition is planned here; every Run replays it and only moves pixels.
+  MPI_Bcast(dims.data(), 3, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+  width_ = dims[0];
+  height_ = dims[1];
+  channels_ = dims[2];
+  radius_ = StencilRadius(options_.stencil);
+  const bool small = width_ <= 2 * radius_ || height_ <= 2 * radius_;
+  if (!small) {
+    grid_ = PickProcessGrid(size, width_, height_);
+    PrepareBuffers(rank, size);
+  }
 
-    const std::size_t pixels = in.width * in.height;
-    gray_.assign(pixels, 0);
+  // The options are fixed per task, so the plan stays valid while the geometry and every buffer its requests point
+  // into stay the same; repeated runs over one image then set up nothing. Plans are collective, and so is the check.
+  const std::array<const void *, 5> buffers = {rank == 0 ? RootPixels() : nullptr, workspace_.out.data(),
+                                               src_chunk_.data(), gray_.data(), local_out_.data()};
+  int stale = (!planned_ || dims != planned_dims_ || buffers != planned_buffers_) ? 1 : 0;
+  MPI_Allreduce(MPI_IN_PLACE, &stale, 1, MPI_INT, MPI_LOR, MPI_COMM_WORLD);
+  if (stale == 0) {
+    return true;
+  }
 
-    if (in.channels == 1) {
-      std::copy(in.data.begin(), in.data.end(), gray_.begin());
-    } else {
-      for (std::size_t i = 0; i < pixels; ++i) {
-        const uint8_t r = in.data[i * 3 + 0];
-        const uint8_t g = in.data[i * 3 + 1];
-        const uint8_t b = in.data[i * 3 + 2];
-        const int y = (77 * r + 150 * g + 29 * b) >> 8;
-        gray_[i] = static_cast<uint8_t>(y);
-      }
-    }
+  ReleasePlan();
+  planned_ = true;
+  planned_dims_ = dims;
+  planned_buffers_ = buffers;
+  if (small) {
+    return width_ != 0 && height_ != 0;
+  }
+
+  if (grid_.cols > 1) {
+    PlanBlocks(rank);
+  } else if (options_.comm == SobelCommMode::kOverlapped) {
+    PlanOverlapped(rank, size);
+  } else if (options_.transport == SobelTransport::kSharedWindow) {
+    PlanShared(rank);
+  } else {
+    PlanStrips(rank, size);
   }
 
+  // The grayscale conversion happens per rank in Run, on the strip each rank receives.
   return true;
 }
 
+void SobelEdgeDetectionMPI::PrepareBuffers(int rank, int size) {
+  const std::size_t w = width_;
+  if (grid_.cols > 1) {
+    const BlockExtent block = BlockOf(rank, grid_, w, height_);
+    const std::size_t pitch = block.cols + 2;
+    // The scatter, the conversion and the halo exchange overwrite the blocks except for the halo ring at the image
+    // edge, which the kernel never reads, and the output pixels on the image border, which it never writes; two
+    // rings of the padded output block cover all of those.
+    src_chunk_.resize(block.rows * block.cols * channels_);
+    gray_.resize((block.rows + 2) * pitch);
+    ZeroBorder(gray_.data(), pitch, block.rows + 2);
+    local_out_.resize((block.rows + 2) * pitch);
+    ZeroBorder(local_out_.data(), pitch, block.rows + 2, 2);
+    return;
+  }
+
+  const bool overlapped = options_.comm == SobelCommMode::kOverlapped;
+  if (!overlapped && options_.transport == SobelTransport::kSharedWindow) {
+    return;  // the strips live in the shared window
+  }
+  // The scatter and the conversion overwrite these completely; the output strip only needs a zero border.
+  const RowStrip strip = StripOf(static_cast<std::size_t>(rank), static_cast<std::size_t>(size), height_, radius_);
+  src_chunk_.resize(strip.RecvRows() * w * channels_);
+  if (channels_ != 1 && !Fused()) {
+    gray_.resize(strip.RecvRows() * w);
+  }
+  // Rank 0 of the blocking strips filters its gathered rows straight into the workspace output; everyone else needs
+  // a strip of its own.
+  if (overlapped || options_.output != SobelOutputMode::kGathered || rank != 0) {
+    local_out_.resize(strip.rows * w);
+    ZeroStripBorder(local_out_.data(), w, strip.start, strip.rows, height_, radius_);
+  }
+}
+
+void SobelEdgeDetectionMPI::PlanStrips(int rank, int size) {
+  const auto nranks = static_cast<std::size_t>(size);
+  const std::size_t w = width_;
+  const std::size_t row_bytes = w * channels_;
+  const RowStrip strip = StripOf(static_cast<std::size_t>(rank), nranks, height_, radius_);
+  const bool exchange = options_.halo == SobelHaloMode::kExchange;
+  const bool gather = options_.output == SobelOutputMode::kGathered;
+
+  in_row_ = MakeRowType(row_bytes);
+  out_row_ = MakeRowType(w);
+
+  // Persistent point-to-point requests stand in for Scatterv/Gatherv; rank 0 takes part in neither, since it reads
+  // its own rows from the input and writes them into the workspace output directly.
+  if (rank == 0) {
+    for (std::size_t r = 1; r < nranks; ++r) {
+      const RowStrip other = StripOf(r, nranks, height_, radius_);
+      if (other.rows == 0) {
+        continue;
+      }
+      const std::size_t first_row = exchange ? other.start : other.start - other.halo_top;
+      const std::size_t rows = exchange ? other.rows : other.RecvRows();
+      scatter_requests_.emplace_back();
+      MPI_Send_init(RootPixels() + (first_row * row_bytes), static_cast<int>(rows), in_row_,
+                    static_cast<int>(r), kTagScatter, MPI_COMM_WORLD, &scatter_requests_.back());
+      if (gather) {
+        gather_requests_.emplace_back();
+        MPI_Recv_init(workspace_.out.data() + (other.start * w), static_cast<int>(other.rows), out_row_,
+                      static_cast<int>(r), kTagGather, MPI_COMM_WORLD, &gather_requests_.back());
+      }
+    }
+  } else if (strip.rows > 0) {
+    // In exchange mode only the owned rows arrive; the halo slots around them are filled by the neighbours.
+    scatter_requests_.emplace_back();
+    MPI_Recv_init(src_chunk_.data() + (exchange ? strip.halo_top * row_bytes : 0),
+                  static_cast<int>(exchange ? strip.rows : strip.RecvRows()), in_row_, 0, kTagScatter, MPI_COMM_WORLD,
+                  &scatter_requests_.back());
+    if (gather) {
+      gather_requests_.emplace_back();
+      MPI_Send_init(local_out_.data(), static_cast<int>(strip.rows), out_row_, 0, kTagGather, MPI_COMM_WORLD,
+                    &gather_requests_.back());
+    }
+  }
+}
+
 bool SobelEdgeDetectionMPI::RunImpl() {
   int rank = 0;
   int size = 1;
   MPI_Comm_rank(MPI_COMM_WORLD, &rank);
   MPI_Comm_size(MPI_COMM_WORLD, &size);
 
-  std::size_t w = 0;
-  std::size_t h = 0;
-
-  if (rank == 0) {
-    w = GetInput().width;
-    h = GetInput().height;
-  }
-
-  MPI_Bcast(&w, 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
-  MPI_Bcast(&h, 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+  const std::size_t w = width_;
+  const std::size_t h = height_;
+  const std::size_t ch = channels_;
 
   if (w == 0 || h == 0) {
     return false;
   }
 
-  if (w < 3 || h < 3) {
+  if (w <= 2 * radius_ || h <= 2 * radius_) {
     if (rank == 0) {
-      std::fill(out_data_.begin(), out_data_.end(), 0);
+      std::fill(workspace_.out.begin(), workspace_.out.end(), 0);
     }
-    MPI_Barrier(MPI_COMM_WORLD);
+    const RowStrip strip = StripOf(static_cast<std::size_t>(rank), static_cast<std::size_t>(size), h);
+    output_strip_ = OutputStrip{.row_start = strip.start, .rows = strip.rows, .width = w, .height = h};
+    local_out_.assign(strip.rows * w, 0);
     return true;
   }
 
-  const std::size_t base = h / static_cast<std::size_t>(size);
-  const std::size_t rem = h % static_cast<std::size_t>(size);
+  if (grid_.cols > 1) {
+    return RunBlocks(w, h, ch);
+  }
+
+  if (options_.comm == SobelCommMode::kOverlapped) {
+    return RunOverlapped(rank, size, w, h, ch);
+  }
 
-  const std::size_t local_rows = base + (static_cast<std::size_t>(rank) < rem ? 1 : 0);
+  if (options_.transport == SobelTransport::kSharedWindow) {
+    return RunShared(rank);
+  }
+
+  const RowStrip strip = StripOf(static_cast<std::size_t>(rank), static_cast<std::size_t>(size), h, radius_);
+  const std::size_t local_rows = strip.rows;
+  const std::size_t halo_top = strip.halo_top;
+  const bool exchange = options_.halo == SobelHaloMode::kExchange;
+  const bool gather = options_.output == SobelOutputMode::kGathered;
+  output_strip_ = OutputStrip{.row_start = strip.start, .rows = local_rows, .width = w, .height = h};
+
+  // Strips travel as raw interleaved pixels, so a row is w * ch bytes on the wire. Rank 0 owns the top rows of the
+  // input and reads them in place; only exchange mode copies them, as it writes the bottom halo next to them.
+  const std::size_t row_bytes = w * ch;
+  const std::size_t recv_rows = strip.RecvRows();
+  uint8_t *src_chunk = src_chunk_.data();
+  uint8_t *recv_buf = src_chunk + (exchange ? halo_top * row_bytes : 0);
+  const uint8_t *src = src_chunk;
+  if (rank == 0) {
+    if (exchange) {
+      std::copy_n(RootPixels(), local_rows * row_bytes, recv_buf);
+    } else {
+      src = RootPixels();
+    }
+  }
+  StartAndWait(scatter_requests_);
+
+  // Every rank converts its own strip; single-channel strips are used as they arrived.
+  const bool gray_strip = ch != 1 && !Fused();
+  if (gray_strip) {
+    if (exchange) {
+      // Convert the owned rows only and swap gray halos, a third of the RGB halo traffic.
+      GrayRow(recv_buf, ch, gray_.data() + (halo_top * w), local_rows * w);
+    } else {
+      GrayRow(src, ch, gray_.data(), recv_rows * w);
+    }
+  }
 
-  const std::size_t start_row =
-      base * static_cast<std::size_t>(rank) + std::min<std::size_t>(static_cast<std::size_t>(rank), rem);
+  if (exchange && local_rows > 0) {
+    ExchangeHaloRows(gray_strip ? gray_.data() : src_chunk, gray_strip ? w : row_bytes, local_rows, halo_top,
+                     strip.halo_top > 0 ? rank - 1 : MPI_PROC_NULL, strip.halo_bottom > 0 ? rank + 1 : MPI_PROC_NULL);
+  }
 
-  const bool has_top = (start_row > 0);
-  const bool has_bottom = (start_row + local_rows < h);
-  const std::size_t halo_top = has_top ? 1 : 0;
-  const std::size_t halo_bottom = has_bottom ? 1 : 0;
+  // The border rows and columns were zeroed when the output was prepared and are never written, so they stay zero.
+  uint8_t *own_out = (gather && rank == 0) ? workspace_.out.data() : local_out_.data();
+  FilterRows(gray_strip ? gray_.data() : src, gray_strip ? 1 : ch, w, strip, h, 0, local_rows, own_out);
 
-  const std::size_t recv_rows = local_rows + halo_top + halo_bottom;
-  const std::size_t recv_count = recv_rows * w;
+  StartAndWait(gather_requests_);
+  return true;
+}
 
-  std::vector<uint8_t> gray_chunk(recv_count, 0);
+void SobelEdgeDetectionMPI::PlanOverlapped(int rank, int size) {
+  const auto nranks = static_cast<std::size_t>(size);
+  const std::size_t blocks = options_.comm_blocks;
+  const std::size_t w = width_;
+  const std::size_t row_bytes = w * channels_;
 
-  std::vector<int> sendcounts;
-  std::vector<int> displs;
+  // Every strip (halos included) is cut into `blocks` row pieces; piece k of all ranks travels in the k-th
+  // Iscatterv, and the output rows it completes go back in the k-th Igatherv.
   if (rank == 0) {
-    sendcounts.resize(size, 0);
-    displs.resize(size, 0);
+    sendcounts_.resize(blocks * nranks);
+    displs_.resize(blocks * nranks);
+    recvcounts_.resize(blocks * nranks);
+    recv_displs_.resize(blocks * nranks);
+
+    for (std::size_t r = 0; r < nranks; ++r) {
+      const RowStrip other = StripOf(r, nranks, height_);
+      for (std::size_t k = 0; k < blocks; ++k) {
+        const auto [piece_begin, piece_end] = other.Piece(k, blocks);
+        const auto [out_begin, out_end] = other.PieceOutput(k, blocks);
+        const std::size_t idx = (k * nranks) + r;
+
+        sendcounts_[idx] = static_cast<int>(piece_end - piece_begin);
+        displs_[idx] = static_cast<int>(other.start - other.halo_top + piece_begin);
+        recvcounts_[idx] = static_cast<int>(out_end - out_begin);
+        recv_displs_[idx] = static_cast<int>(other.start + out_begin);
+      }
+    }
+  }
 
-    for (int r = 0; r < size; ++r) {
-      const std::size_t lr = base + (static_cast<std::size_t>(r) < rem ? 1 : 0);
-      const std::size_t sr =
-          base * static_cast<std::size_t>(r) + std::min<std::size_t>(static_cast<std::size_t>(r), rem);
+  // MPI 3.1 has no persistent collectives, so Run still starts the pieces; the slots only hold their requests.
+  piece_scatters_.assign(blocks, MPI_REQUEST_NULL);
+  piece_gathers_.assign(blocks, MPI_REQUEST_NULL);
+  in_row_ = MakeRowType(row_bytes);
+  out_row_ = MakeRowType(w);
+}
+
+bool SobelEdgeDetectionMPI::RunOverlapped(int rank, int size, std::size_t w, std::size_t h, std::size_t ch) {
+  const auto nranks = static_cast<std::size_t>(size);
+  const std::size_t blocks = options_.comm_blocks;
+  const std::size_t row_bytes = w * ch;
+  const RowStrip strip = StripOf(static_cast<std::size_t>(rank), nranks, h);
+  const bool gather = options_.output == SobelOutputMode::kGathered;
+  output_strip_ = OutputStrip{.row_start = strip.start, .rows = strip.rows, .width = w, .height = h};
+
+  for (std::size_t k = 0; k < blocks; ++k) {
+    const auto [piece_begin, piece_end] = strip.Piece(k, blocks);
+    const std::size_t idx = k * nranks;
+    MPI_Iscatterv(rank == 0 ? RootPixels() : nullptr, rank == 0 ? sendcounts_.data() + idx : nullptr,
+                  rank == 0 ? displs_.data() + idx : nullptr, in_row_, src_chunk_.data() + (piece_begin * row_bytes),
+                  static_cast<int>(piece_end - piece_begin), in_row_, 0, MPI_COMM_WORLD, &piece_scatters_[k]);
+  }
 
-      const bool top = (sr > 0);
-      const bool bottom = (sr + lr < h);
-      const std::size_t ht = top ? 1 : 0;
-      const std::size_t hb = bottom ? 1 : 0;
+  const bool gray_strip = ch != 1 && !Fused();
+  for (std::size_t k = 0; k < blocks; ++k) {
+    MPI_Wait(&piece_scatters_[k], MPI_STATUS_IGNORE);
 
-      const std::size_t rr = lr + ht + hb;
-      const std::size_t count = rr * w;
-      const std::size_t disp_row = sr - ht;
-      const std::size_t disp = disp_row * w;
+    // Rows of piece k are converted and every output row whose three source rows are now present is filtered,
+    // while the later pieces are still in flight.
+    const auto [piece_begin, piece_end] = strip.Piece(k, blocks);
+    if (gray_strip) {
+      GrayRow(src_chunk_.data() + (piece_begin * row_bytes), ch, gray_.data() + (piece_begin * w),
+              (piece_end - piece_begin) * w);
+    }
+
+    const auto [out_begin, out_end] = strip.PieceOutput(k, blocks);
+    FilterRows(gray_strip ? gray_.data() : src_chunk_.data(), gray_strip ? 1 : ch, w, strip, h, out_begin, out_end,
+               local_out_.data());
 
-      sendcounts[r] = static_cast<int>(count);
-      displs[r] = static_cast<int>(disp);
+    if (gather) {
+      const std::size_t idx = k * nranks;
+      MPI_Igatherv(local_out_.data() + (out_begin * w), static_cast<int>(out_end - out_begin), out_row_,
+                   rank == 0 ? workspace_.out.data() : nullptr, rank == 0 ? recvcounts_.data() + idx : nullptr,
+                   rank == 0 ? recv_displs_.data() + idx : nullptr, out_row_, 0, MPI_COMM_WORLD, &piece_gathers_[k]);
     }
   }
 
-  MPI_Scatterv(rank == 0 ? gray_.data() : nullptr, rank == 0 ? sendcounts.data() : nullptr,
-               rank == 0 ? displs.data() : nullptr, MPI_UNSIGNED_CHAR, gray_chunk.data(), static_cast<int>(recv_count),
-               MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+  MPI_Waitall(static_cast<int>(blocks), piece_gathers_.data(), MPI_STATUSES_IGNORE);
+  return true;
+}
 
-  std::vector<uint8_t> local_out(local_rows * w, 0);
+void SobelEdgeDetectionMPI::PlanShared(int rank) {
+  SharedNode &sh = shared_;
 
-  auto idx_local = [w](std::size_t x, std::size_t y) { return y * w + x; };
+  // Ranks sharing memory form one node; its lowest world rank leads it, so rank 0 leads its node and is rank 0
+  // among the leaders.
+  MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &sh.node);
+  MPI_Comm_rank(sh.node, &sh.node_rank);
+  MPI_Comm_size(sh.node, &sh.node_size);
 
-  for (std::size_t y = 0; y < local_rows; ++y) {
-    const std::size_t global_y = start_row + y;
+  MPI_Comm_split(MPI_COMM_WORLD, sh.node_rank == 0 ? 0 : MPI_UNDEFINED, rank, &sh.leaders);
+  std::array<int, 2> node_info = {0, 1};  // index of this node, number of nodes
+  if (sh.node_rank == 0) {
+    MPI_Comm_rank(sh.leaders, &node_info[0]);
+    MPI_Comm_size(sh.leaders, &node_info[1]);
+  }
+  MPI_Bcast(node_info.data(), 2, MPI_INT, 0, sh.node);
+  sh.nodes = static_cast<std::size_t>(node_info[1]);
+
+  // Strips are split twice: between nodes and, inside a node strip, between the ranks of the node.
+  sh.node_strip = StripOf(static_cast<std::size_t>(node_info[0]), sh.nodes, height_);
+  const std::size_t held_rows = sh.node_strip.RecvRows();
+  const bool gray_strip = channels_ != 1 && !Fused();
+
+  // The leader allocates the whole node strip: raw rows, gray rows (when converted) and output rows.
+  const std::size_t raw_size = held_rows * width_ * channels_;
+  const std::size_t gray_size = gray_strip ? held_rows * width_ : 0;
+  const std::size_t out_size = sh.node_strip.rows * width_;
+  const std::size_t window_size = sh.node_rank == 0 ? raw_size + gray_size + out_size : 0;
+
+  uint8_t *base = nullptr;
+  MPI_Win_allocate_shared(static_cast<MPI_Aint>(window_size), 1, MPI_INFO_NULL, sh.node, &base, &sh.win);
+  MPI_Aint leader_size = 0;
+  int disp_unit = 1;
+  MPI_Win_shared_query(sh.win, 0, &leader_size, &disp_unit, &base);
+  sh.raw = base;
+  sh.gray = sh.raw + raw_size;
+  sh.out = sh.gray + gray_size;
+
+  // Output rows start zeroed once; the border rows and columns are never written afterwards.
+  const RowStrip local = StripOf(static_cast<std::size_t>(sh.node_rank), static_cast<std::size_t>(sh.node_size),
+                                 sh.node_strip.rows);
+  std::fill_n(sh.out + (local.start * width_), local.rows * width_, 0);
+
+  in_row_ = MakeRowType(width_ * channels_);
+  out_row_ = MakeRowType(width_);
+  MPI_Win_lock_all(MPI_MODE_NOCHECK, sh.win);
+  SyncNode(sh.win, sh.node);
+}
 
-    if (global_y == 0 || global_y + 1 == h) {
-      std::fill(local_out.begin() + y * w, local_out.begin() + (y + 1) * w, 0);
-      continue;
+bool SobelEdgeDetectionMPI::RunShared(int rank) {
+  const SharedNode &sh = shared_;
+  const std::size_t w = width_;
+  const std::size_t h = height_;
+  const std::size_t ch = channels_;
+  const std::size_t held_rows = sh.node_strip.RecvRows();
+  const std::size_t row_bytes = w * ch;
+  const bool gray_strip = ch != 1 && !Fused();
+  const bool gather = options_.output == SobelOutputMode::kGathered;
+
+  if (sh.node_rank == 0) {
+    if (sh.nodes == 1) {
+      std::copy_n(RootPixels(), held_rows * row_bytes, sh.raw);
+    } else {
+      if (rank == 0) {
+        sendcounts_.resize(sh.nodes);
+        displs_.resize(sh.nodes);
+        for (std::size_t n = 0; n < sh.nodes; ++n) {
+          const RowStrip other = StripOf(n, sh.nodes, h);
+          sendcounts_[n] = static_cast<int>(other.RecvRows());
+          displs_[n] = static_cast<int>(other.start - other.halo_top);
+        }
+      }
+      MPI_Scatterv(rank == 0 ? RootPixels() : nullptr, rank == 0 ? sendcounts_.data() : nullptr,
+                   rank == 0 ? displs_.data() : nullptr, in_row_, sh.raw, static_cast<int>(held_rows), in_row_, 0,
+                   sh.leaders);
     }
+  }
+  SyncNode(sh.win, sh.node);
+
+  const auto node_ranks = static_cast<std::size_t>(sh.node_size);
+  const auto node_index = static_cast<std::size_t>(sh.node_rank);
+  if (gray_strip) {
+    // Held rows (halos included) are converted in equal shares, straight from the window into the window.
+    const std::size_t first = held_rows * node_index / node_ranks;
+    const std::size_t last = held_rows * (node_index + 1) / node_ranks;
+    GrayRow(sh.raw + (first * row_bytes), ch, sh.gray + (first * w), (last - first) * w);
+    SyncNode(sh.win, sh.node);
+  }
 
-    const std::size_t cy = y + halo_top;
+  const RowStrip local = StripOf(node_index, node_ranks, sh.node_strip.rows);
+  output_strip_ =
+      OutputStrip{.row_start = sh.node_strip.start + local.start, .rows = local.rows, .width = w, .height = h};
+  if (local.rows > 0) {
+    RowStrip strip;
+    strip.start = sh.node_strip.start + local.start;
+    strip.rows = local.rows;
+    strip.halo_top = strip.start > 0 ? 1 : 0;
+    strip.halo_bottom = strip.start + strip.rows < h ? 1 : 0;
+
+    const std::size_t src_channels = gray_strip ? 1 : ch;
+    const uint8_t *src = (gray_strip ? sh.gray : sh.raw) +
+                         ((sh.node_strip.halo_top + local.start - strip.halo_top) * w * src_channels);
+    FilterRows(src, src_channels, w, strip, h, 0, local.rows, sh.out + (local.start * w));
+  }
+  SyncNode(sh.win, sh.node);
 
-    local_out[idx_local(0, y)] = 0;
-    local_out[idx_local(w - 1, y)] = 0;
+  if (!gather) {
+    // The window goes away in PostProcessing, so each rank takes a private copy of its own rows.
+    const uint8_t *own = sh.out + (local.start * w);
+    local_out_.assign(own, own + (local.rows * w));
+  }
 
-    for (std::size_t x = 1; x + 1 < w; ++x) {
-      const int p00 = static_cast<int>(gray_chunk[idx_local(x - 1, cy - 1)]);
-      const int p10 = static_cast<int>(gray_chunk[idx_local(x, cy - 1)]);
-      const int p20 = static_cast<int>(gray_chunk[idx_local(x + 1, cy - 1)]);
+  if (gather && sh.node_rank == 0) {
+    if (sh.nodes == 1) {
+      std::copy_n(sh.out, sh.node_strip.rows * w, workspace_.out.data());
+    } else {
+      if (rank == 0) {
+        recvcounts_.resize(sh.nodes);
+        recv_displs_.resize(sh.nodes);
+        for (std::size_t n = 0; n < sh.nodes; ++n) {
+          const RowStrip other = StripOf(n, sh.nodes, h);
+          recvcounts_[n] = static_cast<int>(other.rows);
+          recv_displs_[n] = static_cast<int>(other.start);
+        }
+      }
+      MPI_Gatherv(sh.out, static_cast<int>(sh.node_strip.rows), out_row_,
+                  rank == 0 ? workspace_.out.data() : nullptr, rank == 0 ? recvcounts_.data() : nullptr,
+                  rank == 0 ? recv_displs_.data() : nullptr, out_row_, 0, sh.leaders);
+    }
+  }
+  return true;
+}
 
-      const int p01 = static_cast<int>(gray_chunk[idx_local(x - 1, cy)]);
-      const int p21 = static_cast<int>(gray_chunk[idx_local(x + 1, cy)]);
+void SobelEdgeDetectionMPI::ReleaseLocalPlan() {
+  for (auto &request : scatter_requests_) {
+    MPI_Request_free(&request);
+  }
+  for (auto &request : gather_requests_) {
+    MPI_Request_free(&request);
+  }
+  scatter_requests_.clear();
+  gather_requests_.clear();
+  if (in_row_ != MPI_DATATYPE_NULL) {
+    MPI_Type_free(&in_row_);
+  }
+  if (out_row_ != MPI_DATATYPE_NULL) {
+    MPI_Type_free(&out_row_);
+  }
 
-      const int p02 = static_cast<int>(gray_chunk[idx_local(x - 1, cy + 1)]);
-      const int p12 = static_cast<int>(gray_chunk[idx_local(x, cy + 1)]);
-      const int p22 = static_cast<int>(gray_chunk[idx_local(x + 1, cy + 1)]);
+  BlockPlan &bp = blocks_;
+  for (MPI_Datatype *type : {&bp.column, &bp.padded_row, &bp.out_block}) {
+    if (*type != MPI_DATATYPE_NULL) {
+      MPI_Type_free(type);
+    }
+  }
+  for (auto &type : bp.root_types) {
+    MPI_Type_free(&type);
+  }
+  // MPI_Comm_free only marks the communicator for deallocation; it does not wait for the other ranks.
+  if (bp.cart != MPI_COMM_NULL) {
+    MPI_Comm_free(&bp.cart);
+  }
+  bp = BlockPlan{};
+  planned_ = false;
+}
+
+void SobelEdgeDetectionMPI::ReleasePlan() {
+  ReleaseLocalPlan();
 
-      const int gx = (-p00 + p20) + (-2 * p01 + 2 * p21) + (-p02 + p22);
-      const int gy = (-p00 - 2 * p10 - p20) + (p02 + 2 * p12 + p22);
+  SharedNode &sh = shared_;
+  if (sh.win != MPI_WIN_NULL) {
+    MPI_Win_unlock_all(sh.win);
+    MPI_Win_free(&sh.win);
+  }
+  if (sh.leaders != MPI_COMM_NULL) {
+    MPI_Comm_free(&sh.leaders);
+  }
+  if (sh.node != MPI_COMM_NULL) {
+    MPI_Comm_free(&sh.node);
+  }
+  sh = SharedNode{};
+}
 
-      int mag = std::abs(gx) + std::abs(gy);
-      mag /= 4;
+ProcessGrid SobelEdgeDetectionMPI::PickProcessGrid(int size, std::size_t w, std::size_t h) const {
+  const ProcessGrid strips{.rows = size, .cols = 1};
+  if (options_.decomposition == SobelDecomposition::kRows) {
+    return strips;
+  }
+  if (options_.decomposition == SobelDecomposition::kAuto && UsesStripOnlyOptions(options_)) {
+    return strips;
+  }
 
-      local_out[idx_local(x, y)] = ClampToU8(mag);
+  // Among the grids with more than one column that leave every rank at least one row and one column, take the one
+  // with the shortest total internal boundary, i.e. the fewest halo pixels.
+  const auto nranks = static_cast<std::size_t>(size);
+  std::size_t best_cols = 1;
+  std::size_t best_cost = 0;
+  for (std::size_t cols = 2; cols <= nranks; ++cols) {
+    const std::size_t rows = nranks / cols;
+    if (nranks % cols != 0 || rows > h || cols > w) {
+      continue;
+    }
+    const std::size_t cost = ((rows - 1) * w) + ((cols - 1) * h);
+    if (best_cols == 1 || cost < best_cost) {
+      best_cols = cols;
+      best_cost = cost;
     }
   }
+  if (best_cols == 1) {
+    return strips;
+  }
 
-  std::vector<int> recvcounts_out;
-  std::vector<int> displs_out;
-  if (rank == 0) {
-    recvcounts_out.resize(size, 0);
-    displs_out.resize(size, 0);
+  // Blocks move strided data and exchange four halos instead of two, so auto mode only switches when they at least
+  // halve the boundary of row strips (wide images) or when there are more ranks than rows.
+  if (options_.decomposition == SobelDecomposition::kAuto && nranks <= h && 2 * best_cost >= (nranks - 1) * w) {
+    return strips;
+  }
 
-    for (int r = 0; r < size; ++r) {
-      const std::size_t lr = base + (static_cast<std::size_t>(r) < rem ? 1 : 0);
-      const std::size_t sr =
-          base * static_cast<std::size_t>(r) + std::min<std::size_t>(static_cast<std::size_t>(r), rem);
+  std::array<int, 2> dims = {0, static_cast<int>(best_cols)};
+  MPI_Dims_create(size, 2, dims.data());
+  return ProcessGrid{.rows = dims[0], .cols = dims[1]};
+}
 
-      recvcounts_out[r] = static_cast<int>(lr * w);
-      displs_out[r] = static_cast<int>(sr * w);
+void SobelEdgeDetectionMPI::PlanBlocks(int rank) {
+  BlockPlan &bp = blocks_;
+  const std::size_t w = width_;
+  const std::size_t ch = channels_;
+  const std::array<int, 2> dims = {grid_.rows, grid_.cols};
+  const std::array<int, 2> periods = {0, 0};
+  // No reordering: Cartesian ranks stay equal to MPI_COMM_WORLD ranks, so rank 0 keeps the image.
+  MPI_Cart_create(MPI_COMM_WORLD, 2, dims.data(), periods.data(), 0, &bp.cart);
+  MPI_Cart_shift(bp.cart, 1, 1, &bp.left, &bp.right);
+  MPI_Cart_shift(bp.cart, 0, 1, &bp.up, &bp.down);
+
+  bp.extent = BlockOf(rank, grid_, w, height_);
+  const std::size_t bh = bp.extent.rows;
+  const std::size_t bw = bp.extent.cols;
+  const std::size_t pitch = bw + 2;
+  const std::size_t row_bytes = bw * ch;
+
+  // Columns are exchanged over the interior rows, then full padded rows, so the corner pixels travel with the rows.
+  in_row_ = MakeRowType(row_bytes);
+  bp.column = MakeBlockType(bh, 1, pitch);
+  bp.padded_row = MakeRowType(pitch);
+  bp.out_block = MakeBlockType(bh, bw, pitch);
+
+  // Rank 0 sends every block as one strided vector straight out of the interleaved input and receives the output
+  // blocks straight into the frame; it is also the peer of its own block.
+  scatter_requests_.emplace_back();
+  MPI_Recv_init(src_chunk_.data(), static_cast<int>(bh), in_row_, 0, kTagScatter, bp.cart, &scatter_requests_.back());
+  if (rank == 0) {
+    for (int r = 0; r < grid_.rows * grid_.cols; ++r) {
+      const BlockExtent other = BlockOf(r, grid_, w, height_);
+      bp.root_types.push_back(MakeBlockType(other.rows, other.cols * ch, w * ch));
+      scatter_requests_.emplace_back();
+      MPI_Send_init(RootPixels() + (((other.row_start * w) + other.col_start) * ch), 1, bp.root_types.back(), r,
+                    kTagScatter, bp.cart, &scatter_requests_.back());
+
+      bp.root_types.push_back(MakeBlockType(other.rows, other.cols, w));
+      gather_requests_.emplace_back();
+      MPI_Recv_init(workspace_.out.data() + (other.row_start * w) + other.col_start, 1, bp.root_types.back(), r,
+                    kTagGather, bp.cart, &gather_requests_.back());
     }
   }
+  gather_requests_.emplace_back();
+  MPI_Send_init(local_out_.data() + pitch + 1, 1, bp.out_block, 0, kTagGather, bp.cart, &gather_requests_.back());
+}
+
+bool SobelEdgeDetectionMPI::RunBlocks(std::size_t w, std::size_t h, std::size_t ch) {
+  const BlockPlan &bp = blocks_;
+  const BlockExtent &block = bp.extent;
+  const std::size_t bh = block.rows;
+  const std::size_t bw = block.cols;
+  const std::size_t pitch = bw + 2;  // gray block and output rows carry one halo column on each side
+  const std::size_t row_bytes = bw * ch;
+
+  StartAndWait(scatter_requests_);
 
-  MPI_Gatherv(local_out.data(), static_cast<int>(local_out.size()), MPI_UNSIGNED_CHAR,
-              rank == 0 ? out_data_.data() : nullptr, rank == 0 ? recvcounts_out.data() : nullptr,
-              rank == 0 ? displs_out.data() : nullptr, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+  uint8_t *g = gray_.data();
+  for (std::size_t y = 0; y < bh; ++y) {
+    GrayRow(src_chunk_.data() + (y * row_bytes), ch, g + ((y + 1) * pitch) + 1, bw);
+  }
 
-  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Sendrecv(g + pitch + 1, 1, bp.column, bp.left, kTagHalo, g + pitch + bw + 1, 1, bp.column, bp.right, kTagHalo,
+               bp.cart, MPI_STATUS_IGNORE);
+  MPI_Sendrecv(g + pitch + bw, 1, bp.column, bp.right, kTagHalo + 1, g + pitch, 1, bp.column, bp.left, kTagHalo + 1,
+               bp.cart, MPI_STATUS_IGNORE);
+  MPI_Sendrecv(g + pitch, 1, bp.padded_row, bp.up, kTagHalo + 2, g + ((bh + 1) * pitch), 1, bp.padded_row, bp.down,
+               kTagHalo + 2, bp.cart, MPI_STATUS_IGNORE);
+  MPI_Sendrecv(g + (bh * pitch), 1, bp.padded_row, bp.down, kTagHalo + 3, g, 1, bp.padded_row, bp.up, kTagHalo + 3,
+               bp.cart, MPI_STATUS_IGNORE);
+
+  // Output uses the same padded pitch; global border rows and columns stay zero.
+  const std::size_t x_begin = (block.col_start == 0) ? 2 : 1;
+  const std::size_t x_end = (block.col_start + bw == w) ? bw : bw + 1;
+  for (std::size_t y = 1; y <= bh; ++y) {
+    const std::size_t global_y = block.row_start + y - 1;
+    if (global_y == 0 || global_y + 1 == h || x_begin >= x_end) {
+      continue;
+    }
+    SobelRow(g + ((y - 1) * pitch), g + (y * pitch), g + ((y + 1) * pitch), local_out_.data() + (y * pitch), x_begin,
+             x_end);
+  }
+
+  StartAndWait(gather_requests_);
   return true;
 }
 
+void SobelEdgeDetectionMPI::FilterRows(const uint8_t *src_strip, std::size_t src_channels, std::size_t w,
+                                       const RowStrip &strip, std::size_t h, std::size_t y_lo, std::size_t y_hi,
+                                       uint8_t *local_out) {
+  // The image border rows are never computed; they keep the zeros local_out was created with.
+  const std::size_t y_begin = std::max(y_lo, radius_ > strip.start ? radius_ - strip.start : 0);
+  const std::size_t y_end = std::min({y_hi, strip.rows, h - radius_ > strip.start ? h - radius_ - strip.start : 0});
+  if (y_begin >= y_end) {
+    return;
+  }
+
+  const std::size_t rows = y_end - y_begin;
+  const uint8_t *src = src_strip + ((y_begin + strip.halo_top - radius_) * w * src_channels);
+  uint8_t *dst = local_out + (y_begin * w);
+
+  if (options_.stencil != SobelStencil::kSobel) {
+    StencilGrayRowsOf(options_.stencil, src, w, rows, dst);
+  } else if (src_channels != 1) {
+    fused_.Process(options_.kernel, src, src_channels, w, rows, dst);
+  } else if (options_.traversal == SobelTraversal::kTiles) {
+    const SobelTileGrid grid(w, rows, options_);
+    for (std::size_t i = 0; i < grid.Count(); ++i) {
+      SobelTileRows(src, dst, w, grid.Tile(i));
+    }
+  } else {
+    SobelRows(options_.kernel, separable_, src, w, rows, dst);
+  }
+}
+
+bool SobelEdgeDetectionMPI::Fused() const {
+  return options_.stencil == SobelStencil::kSobel && options_.gray == SobelGrayMode::kFused &&
+         options_.traversal == SobelTraversal::kRows;
+}
+
 bool SobelEdgeDetectionMPI::PostProcessingImpl() {
   int rank = 0;
   MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 
+  // The plan, a shared window included, is kept for the next run; PreProcessing replaces it when it goes stale.
+
+  if (options_.output == SobelOutputMode::kDistributed) {
+    // Every rank's output is its own strip: a width x rows image placed at output_strip_.row_start.
+    auto &out = GetOutput();
+    out.width = output_strip_.width;
+    out.height = output_strip_.rows;
+    out.channels = 1;
+    out.data = std::move(local_out_);
+    return out.data.size() == out.width * out.height;
+  }
+
   if (rank == 0) {
     auto &out = GetOutput();
-    out.data = out_data_;
+    workspace_.LendOut(out.data);
     return (out.data.size() == out.width * out.height * out.channels);
   }
 
   return true;
 }
 
+void SobelEdgeDetectionMPI::ReleaseTransfers() {
+  ReleasePlan();
+}
+
+bool SobelEdgeDetectionMPI::GatherOutput() {
+  if (options_.output != SobelOutputMode::kDistributed) {
+    return true;
+  }
+
+  int rank = 0;
+  int size = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+  // Strip placement depends on the transport (node-level split for the shared window), so the root asks every rank
+  // for its row range instead of recomputing it.
+  const std::array<int, 2> own = {static_cast<int>(output_strip_.row_start), static_cast<int>(output_strip_.rows)};
+  std::vector<int> ranges(rank == 0 ? 2 * static_cast<std::size_t>(size) : 0);
+  MPI_Gather(own.data(), 2, MPI_INT, ranges.data(), 2, MPI_INT, 0, MPI_COMM_WORLD);
+
+  std::vector<int> recvcounts;
+  std::vector<int> displs;
+  PixelBuffer<uint8_t> full;
+  if (rank == 0) {
+    recvcounts.resize(size, 0);
+    displs.resize(size, 0);
+    for (std::size_t r = 0; r < static_cast<std::size_t>(size); ++r) {
+      displs[r] = ranges[2 * r];
+      recvcounts[r] = ranges[(2 * r) + 1];
+    }
+    full.assign(output_strip_.width * output_strip_.height, 0);
+  }
+
+  auto &out = GetOutput();
+  MPI_Datatype out_row = MakeRowType(output_strip_.width);
+  MPI_Gatherv(out.data.data(), own[1], out_row, rank == 0 ? full.data() : nullptr,
+              rank == 0 ? recvcounts.data() : nullptr, rank == 0 ? displs.data() : nullptr, out_row, 0,
+              MPI_COMM_WORLD);
+  MPI_Type_free(&out_row);
+
+  if (rank == 0) {
+    out.data = std::move(full);
+    out.height = output_strip_.height;
+    output_strip_.row_start = 0;
+    output_strip_.rows = output_strip_.height;
+  }
+  return true;
+}
+
 }  // namespace rychkova_d_sobel_edge_detection
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "rychkova_d_sobel_edge_detection/common/include/common.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_workspace.hpp"
+#include "task/include/task.hpp"
+
+namespace rychkova_d_sobel_edge_detection {
+
+class SobelEdgeDetectionOMP : public BaseTask {
+ public:
+  static constexpr ppc::task::TypeOfTask GetStaticTypeOfTask() {
+    return ppc::task::TypeOfTask::kOMP;
+  }
+
+  explicit SobelEdgeDetectionOMP(InType in, SobelOptions options = {});
+
+ private:
+  bool ValidationImpl() override;
+  bool PreProcessingImpl() override;
+  bool RunImpl() override;
+  bool PostProcessingImpl() override;
+
+  SobelWorkspace workspace_;
+  SobelOptions options_;
+};
+
+}  // namespace rychkova_d_sobel_edge_detection
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+
+#include "rychkova_d_sobel_edge_detection/common/include/common.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_frame.hpp"
+#include "task/include/task.hpp"
+
+namespace rychkova_d_sobel_edge_detection {
+
+/// @brief Sobel over a packed batch of small images in one pipeline invocation.
+/// @details Threads share out whole images instead of rows of one image, which suits thumbnails whose compute is
+///          smaller than the cost of a task per image. The output packs the single-channel results in input order.
+class SobelBatchOMP : public ppc::task::Task<ImageBatch, ImageBatch> {
+ public:
+  static constexpr ppc::task::TypeOfTask GetStaticTypeOfTask() {
+    return ppc::task::TypeOfTask::kOMP;
+  }
+
+  explicit SobelBatchOMP(ImageBatch in, SobelOptions options = {});
+
+ private:
+  bool ValidationImpl() override;
+  bool PreProcessingImpl() override;
+  bool RunImpl() override;
+  bool PostProcessingImpl() override;
+
+  ImageBatch out_batch_;
+  // One scratch per OpenMP thread, kept from run to run.
+  std::vector<SobelFrameScratch> scratches_;
+  SobelOptions options_;
+};
+
+}  // namespace rychkova_d_sobel_edge_detection
@@ -0,0 +1,132 @@
+#include "rychkova_d_sobel_edge_detection/omp/include/ops_omp.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "rychkova_d_sobel_edge_detection/common/include/common.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_gray.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_kernel.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_pixel.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_stencil.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_tiles.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_workspace.hpp"
+#include "util/include/util.hpp"
+
+namespace rychkova_d_sobel_edge_detection {
+
+SobelEdgeDetectionOMP::SobelEdgeDetectionOMP(InType in, SobelOptions options) : options_(options) {
+  SetTypeOfTask(GetStaticTypeOfTask());
+  GetInput() = std::move(in);
+  GetOutput() = OutType{};
+}
+
+bool SobelEdgeDetectionOMP::ValidationImpl() {
+  const auto &in = GetInput();
+  if (in.width == 0 || in.height == 0) {
+    return false;
+  }
+  if (!ValidPixelFormat(in.channels, in.layout)) {
+    return false;
+  }
+  if (!ValidTiling(options_)) {
+    return false;
+  }
+
+  if (!ValidImageBuffer(in)) {
+    return false;
+  }
+
+  const auto &out = GetOutput();
+  return out.data.empty() && out.width == 0 && out.height == 0;
+}
+
+bool SobelEdgeDetectionOMP::PreProcessingImpl() {
+  const auto &in = GetInput();
+
+  const std::size_t pixels = in.width * in.height;
+  auto &out = GetOutput();
+  workspace_.PrepareOut(out.data, in.width, in.height, StencilRadius(options_.stencil));
+
+  // Colour -> grayscale in any layout, a chunk of pixels per iteration; a plain copy for single-channel input
+  uint8_t *dst = workspace_.PrepareGray(pixels);
+  const std::size_t chunks = (pixels + kGrayChunkPixels - 1) / kGrayChunkPixels;
+
+#pragma omp parallel for default(none) shared(in, dst, pixels, chunks) schedule(static) \
+    num_threads(ppc::util::GetNumThreads())
+  for (std::size_t k = 0; k < chunks; ++k) {
+    GrayPixels(in, dst, k * kGrayChunkPixels, std::min(pixels, (k + 1) * kGrayChunkPixels));
+  }
+
+  out.width = in.width;
+  out.height = in.height;
+  out.channels = 1;
+
+  return true;
+}
+
+bool SobelEdgeDetectionOMP::RunImpl() {
+  const auto &in = GetInput();
+  const std::size_t w = in.width;
+  const std::size_t h = in.height;
+
+  if (w == 0 || h == 0) {
+    return false;
+  }
+
+  const std::size_t radius = StencilRadius(options_.stencil);
+  if (w <= 2 * radius || h <= 2 * radius) {
+    std::fill(workspace_.out.begin(), workspace_.out.end(), 0);
+    return true;
+  }
+
+  const uint8_t *gray = workspace_.gray.data();
+  uint8_t *out = workspace_.out.data();
+
+  if (options_.stencil != SobelStencil::kSobel) {
+    const SobelStencil stencil = options_.stencil;
+    const std::size_t rows = h - (2 * radius);
+    uint8_t *interior = out + (radius * w);
+
+#pragma omp parallel for default(none) shared(stencil, gray, interior, w, rows) schedule(static) \
+    num_threads(ppc::util::GetNumThreads())
+    for (std::size_t y = 0; y < rows; ++y) {
+      StencilGrayRowsOf(stencil, gray + (y * w), w, 1, interior + (y * w));
+    }
+    return true;
+  }
+
+  if (options_.traversal == SobelTraversal::kTiles) {
+    const SobelTileGrid grid(w, h - 2, options_);
+    const std::size_t num_tiles = grid.Count();
+    uint8_t *interior = out + w;
+
+#pragma omp parallel for default(none) shared(grid, gray, interior, w, num_tiles) schedule(static) \
+    num_threads(ppc::util::GetNumThreads())
+    for (std::size_t i = 0; i < num_tiles; ++i) {
+      SobelTileRows(gray, interior, w, grid.Tile(i));
+    }
+    return true;
+  }
+
+#pragma omp parallel for default(none) shared(gray, out, w, h) schedule(static) num_threads(ppc::util::GetNumThreads())
+  for (std::size_t y = 1; y < h - 1; ++y) {
+    const uint8_t *above = gray + ((y - 1) * w);
+    const uint8_t *row = gray + (y * w);
+    const uint8_t *below = gray + ((y + 1) * w);
+    uint8_t *dst = out + (y * w);
+
+    SobelRow(above, row, below, dst, 1, w - 1);
+  }
+
+  return true;
+}
+
+bool SobelEdgeDetectionOMP::PostProcessingImpl() {
+  auto &out = GetOutput();
+  workspace_.LendOut(out.data);
+  return (out.data.size() == out.width * out.height * out.channels);
+}
+
+}  // namespace rychkova_d_sobel_edge_detection
@@ -0,0 +1,107 @@
+#include "rychkova_d_sobel_edge_detection/omp/include/ops_omp_batch.hpp"
+
+#include <omp.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "rychkova_d_sobel_edge_detection/common/include/common.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_frame.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_stencil.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_tiles.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_workspace.hpp"
+#include "util/include/util.hpp"
+
+namespace rychkova_d_sobel_edge_detection {
+
+namespace {
+
+// Images handed to a thread at a time; small enough to balance mixed sizes, large enough to amortize scheduling.
+constexpr std::size_t kImagesPerChunk = 8;
+
+}  // namespace
+
+SobelBatchOMP::SobelBatchOMP(ImageBatch in, SobelOptions options) : options_(options) {
+  SetTypeOfTask(GetStaticTypeOfTask());
+  GetInput() = std::move(in);
+  GetOutput() = ImageBatch{};
+}
+
+bool SobelBatchOMP::ValidationImpl() {
+  if (!ValidTiling(options_)) {
+    return false;
+  }
+  const auto &in = GetInput();
+  for (const auto &entry : in.entries) {
+    if (entry.width == 0 || entry.height == 0) {
+      return false;
+    }
+    if (entry.channels != 1 && entry.channels != 3) {
+      return false;
+    }
+    const std::size_t bytes = entry.width * entry.height * entry.channels;
+    if (entry.offset > in.data.size() || bytes > in.data.size() - entry.offset) {
+      return false;
+    }
+  }
+
+  const auto &out = GetOutput();
+  return out.data.empty() && out.entries.empty();
+}
+
+bool SobelBatchOMP::PreProcessingImpl() {
+  // The batch lent to the output by the previous run is taken back, so a repeated batch reuses its buffer; Run
+  // clears the image borders, the only pixels the kernels do not write.
+  const auto &in = GetInput();
+  out_batch_ = std::move(GetOutput());
+  GetOutput() = ImageBatch{};
+  out_batch_.entries.resize(in.entries.size());
+  std::size_t offset = 0;
+  for (std::size_t i = 0; i < in.entries.size(); ++i) {
+    const BatchEntry &src = in.entries[i];
+    out_batch_.entries[i] = BatchEntry{.offset = offset, .width = src.width, .height = src.height, .channels = 1};
+    offset += src.width * src.height;
+  }
+  out_batch_.data.resize(offset);
+  scratches_.resize(static_cast<std::size_t>(std::max(ppc::util::GetNumThreads(), 1)));
+  return true;
+}
+
+bool SobelBatchOMP::RunImpl() {
+  const auto &in = GetInput();
+  const std::size_t count = in.entries.size();
+  const BatchEntry *entries = in.entries.data();
+  const BatchEntry *out_entries = out_batch_.entries.data();
+  const uint8_t *src = in.data.data();
+  uint8_t *dst = out_batch_.data.data();
+  const SobelOptions &options = options_;
+  SobelFrameScratch *scratches = scratches_.data();
+  const std::size_t radius = StencilRadius(options.stencil);
+
+#pragma omp parallel default(none) shared(options, entries, out_entries, src, dst, count, scratches, radius) \
+    num_threads(static_cast<int>(scratches_.size()))
+  {
+    // Scratch rows are kept per thread from run to run, so no allocation happens per image once they warmed up.
+    SobelFrameScratch &scratch = scratches[omp_get_thread_num()];
+#pragma omp for schedule(dynamic, kImagesPerChunk)
+    for (std::size_t i = 0; i < count; ++i) {
+      const BatchEntry &entry = entries[i];
+      uint8_t *out = dst + out_entries[i].offset;
+      ZeroBorder(out, entry.width, entry.height, radius);
+      SobelFrame(options, src + entry.offset, entry.channels, entry.width, entry.height, scratch, out);
+    }
+  }
+
+  return true;
+}
+
+bool SobelBatchOMP::PostProcessingImpl() {
+  auto &out = GetOutput();
+  out = std::move(out_batch_);
+  return out.entries.size() == GetInput().entries.size();
+}
+
+}  // namespace rychkova_d_sobel_edge_detection
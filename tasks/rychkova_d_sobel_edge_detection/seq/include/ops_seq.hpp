@@ -1,17 +1,29 @@
 #pragma once
 
+#include <cstdint>
+
 #include "rychkova_d_sobel_edge_detection/common/include/common.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_fused.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_separable.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_workspace.hpp"
 #include "task/include/task.hpp"
 
 namespace rychkova_d_sobel_edge_detection {
 
-class SobelEdgeDetectionSEQ : public BaseTask {
+/// @brief Sequential Sobel over images of @p Pixel samples; the output has the input's pixel type.
+/// @details uint8_t runs every kernel, gray and traversal option. uint16_t and float keep their full precision
+///          (see SobelPixelTraits) and always run the direct kernel over a gray frame, in rows or tiles; the
+///          kernel and gray options only pick a strategy, so the results are the same either way. Every pixel
+///          type runs every SobelStencil.
+///          Instantiated for uint8_t, uint16_t and float in ops_seq.cpp.
+template <typename Pixel>
+class BasicSobelEdgeDetectionSEQ : public ppc::task::Task<BasicImage<Pixel>, BasicImage<Pixel>> {
  public:
   static constexpr ppc::task::TypeOfTask GetStaticTypeOfTask() {
     return ppc::task::TypeOfTask::kSEQ;
   }
 
-  explicit SobelEdgeDetectionSEQ(const InType &in);
+  explicit BasicSobelEdgeDetectionSEQ(BasicImage<Pixel> in, SobelOptions options = {});
 
  private:
   bool ValidationImpl() override;
@@ -19,8 +31,19 @@ class SobelEdgeDetectionSEQ : public BaseTask {
   bool RunImpl() override;
   bool PostProcessingImpl() override;
 
-  std::vector<uint8_t> gray_;
-  std::vector<uint8_t> out_data_;
+  /// @brief Whether the fused kernel converts the input rows itself, so no grayscale frame is built.
+  [[nodiscard]] bool FusedGray();
+
+  BasicSobelWorkspace<Pixel> workspace_;
+  SobelOptions options_;
+  SobelSeparableRing separable_;
+  SobelFusedWindow fused_;
 };
 
+extern template class BasicSobelEdgeDetectionSEQ<uint8_t>;
+extern template class BasicSobelEdgeDetectionSEQ<uint16_t>;
+extern template class BasicSobelEdgeDetectionSEQ<float>;
+
+using SobelEdgeDetectionSEQ = BasicSobelEdgeDetectionSEQ<uint8_t>;
+
 }  // namespace rychkova_d_sobel_edge_detection
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "rychkova_d_sobel_edge_detection/common/include/common.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_frame.hpp"
+#include "task/include/task.hpp"
+
+namespace rychkova_d_sobel_edge_detection {
+
+/// @brief Out-of-core Sobel: streams a raw, PGM or PPM file through the filter in horizontal strips.
+/// @details Each strip of SobelOptions::strip_rows output rows is read together with the stencil radius rows above
+///          and below it, filtered and appended to the output file before the next one is read, so memory stays
+///          O(width x strip_rows) however tall the image is. The output is a raw or PGM file (following the input
+///          format) with the edge image; the task output describes it.
+class SobelFileSEQ : public ppc::task::Task<ImageFileJob, ImageFile> {
+ public:
+  static constexpr ppc::task::TypeOfTask GetStaticTypeOfTask() {
+    return ppc::task::TypeOfTask::kSEQ;
+  }
+
+  explicit SobelFileSEQ(ImageFileJob in, SobelOptions options = {});
+
+ private:
+  bool ValidationImpl() override;
+  bool PreProcessingImpl() override;
+  bool RunImpl() override;
+  bool PostProcessingImpl() override;
+
+  // Geometry and pixel data offset of the input, probed in Validation.
+  ImageFile layout_;
+  std::size_t data_offset_ = 0;
+  // Raw input rows of one strip plus its halo rows, and the output rows of one strip.
+  std::vector<uint8_t> raw_;
+  std::vector<uint8_t> out_;
+  std::vector<uint8_t> zero_row_;
+  SobelOptions options_;
+  SobelFrameScratch scratch_;
+};
+
+}  // namespace rychkova_d_sobel_edge_detection
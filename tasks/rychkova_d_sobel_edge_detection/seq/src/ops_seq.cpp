@@ -1,83 +1,76 @@
 #include "rychkova_d_sobel_edge_detection/seq/include/ops_seq.hpp"
 
 #include <algorithm>
-#include <cmath>
+#include <cstddef>
 #include <cstdint>
-#include <vector>
+#include <utility>
 
 #include "rychkova_d_sobel_edge_detection/common/include/common.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_fused.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_gray.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_pixel.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_separable.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_stencil.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_tiles.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_workspace.hpp"
 
 namespace rychkova_d_sobel_edge_detection {
 
-namespace {
-
-inline uint8_t ClampToU8(int v) {
-  if (v < 0) {
-    return 0;
-  }
-  if (v > 255) {
-    return 255;
-  }
-  return static_cast<uint8_t>(v);
-}
-
-}  // namespace
-
-SobelEdgeDetectionSEQ::SobelEdgeDetectionSEQ(const InType &in) {
-  SetTypeOfTask(GetStaticTypeOfTask());
-  GetInput() = in;
-  GetOutput() = OutType{};
+template <typename Pixel>
+BasicSobelEdgeDetectionSEQ<Pixel>::BasicSobelEdgeDetectionSEQ(BasicImage<Pixel> in, SobelOptions options)
+    : options_(options) {
+  this->SetTypeOfTask(GetStaticTypeOfTask());
+  this->GetInput() = std::move(in);
+  this->GetOutput() = BasicImage<Pixel>{};
 }
 
-bool SobelEdgeDetectionSEQ::ValidationImpl() {
-  const auto &in = GetInput();
+template <typename Pixel>
+bool BasicSobelEdgeDetectionSEQ<Pixel>::ValidationImpl() {
+  const auto &in = this->GetInput();
   if (in.width == 0 || in.height == 0) {
     return false;
   }
-  if (in.channels != 1 && in.channels != 3) {
+  if (!ValidPixelFormat(in.channels, in.layout)) {
+    return false;
+  }
+  if (!ValidTiling(options_)) {
     return false;
   }
 
-  const std::size_t expected = in.width * in.height * in.channels;
-  if (in.data.size() != expected) {
+  if (!ValidImageBuffer(in)) {
     return false;
   }
 
-  const auto &out = GetOutput();
+  const auto &out = this->GetOutput();
   return out.data.empty() && out.width == 0 && out.height == 0;
 }
 
-bool SobelEdgeDetectionSEQ::PreProcessingImpl() {
-  const auto &in = GetInput();
+template <typename Pixel>
+bool BasicSobelEdgeDetectionSEQ<Pixel>::PreProcessingImpl() {
+  const auto &in = this->GetInput();
 
   const std::size_t pixels = in.width * in.height;
-  gray_.assign(pixels, 0);
-  out_data_.assign(pixels, 0);
+  auto &out = this->GetOutput();
+  workspace_.PrepareOut(out.data, in.width, in.height, StencilRadius(options_.stencil));
 
-  if (in.channels == 1) {
-    std::copy(in.data.begin(), in.data.end(), gray_.begin());
+  if (FusedGray()) {
+    // Run reads the input directly; no grayscale frame is materialized.
+    workspace_.gray.clear();
   } else {
-    // RGB -> grayscale
-    for (std::size_t i = 0; i < pixels; ++i) {
-      const uint8_t r = in.data[i * 3 + 0];
-      const uint8_t g = in.data[i * 3 + 1];
-      const uint8_t b = in.data[i * 3 + 2];
-      const int y = (77 * r + 150 * g + 29 * b) >> 8;
-      gray_[i] = static_cast<uint8_t>(y);
-    }
+    // Colour -> grayscale in any layout; a plain copy for single-channel input
+    GrayPixelsOf(in, workspace_.PrepareGray(pixels), 0, pixels);
   }
 
-  auto &out = GetOutput();
   out.width = in.width;
   out.height = in.height;
   out.channels = 1;
-  out.data.clear();
 
   return true;
 }
 
-bool SobelEdgeDetectionSEQ::RunImpl() {
-  const auto &in = GetInput();
+template <typename Pixel>
+bool BasicSobelEdgeDetectionSEQ<Pixel>::RunImpl() {
+  const auto &in = this->GetInput();
   const std::size_t w = in.width;
   const std::size_t h = in.height;
 
@@ -85,44 +78,51 @@ bool SobelEdgeDetectionSEQ::RunImpl() {
     return false;
   }
 
-  if (w < 3 || h < 3) {
-    std::fill(out_data_.begin(), out_data_.end(), 0);
+  const std::size_t radius = StencilRadius(options_.stencil);
+  if (w <= 2 * radius || h <= 2 * radius) {
+    std::fill(workspace_.out.begin(), workspace_.out.end(), 0);
     return true;
   }
 
-  auto idx = [w](std::size_t x, std::size_t y) { return y * w + x; };
-
-  for (std::size_t y = 1; y + 1 < h; ++y) {
-    for (std::size_t x = 1; x + 1 < w; ++x) {
-      const int p00 = static_cast<int>(gray_[idx(x - 1, y - 1)]);
-      const int p10 = static_cast<int>(gray_[idx(x, y - 1)]);
-      const int p20 = static_cast<int>(gray_[idx(x + 1, y - 1)]);
+  const Pixel *gray = workspace_.gray.data();
+  Pixel *interior = workspace_.out.data() + (radius * w);
 
-      const int p01 = static_cast<int>(gray_[idx(x - 1, y)]);
-      const int p21 = static_cast<int>(gray_[idx(x + 1, y)]);
-
-      const int p02 = static_cast<int>(gray_[idx(x - 1, y + 1)]);
-      const int p12 = static_cast<int>(gray_[idx(x, y + 1)]);
-      const int p22 = static_cast<int>(gray_[idx(x + 1, y + 1)]);
-
-      const int gx = (-p00 + p20) + (-2 * p01 + 2 * p21) + (-p02 + p22);
-      const int gy = (-p00 - 2 * p10 - p20) + (p02 + 2 * p12 + p22);
-
-      int mag = std::abs(gx) + std::abs(gy);
-
-      mag /= 4;
-
-      out_data_[idx(x, y)] = ClampToU8(mag);
+  // The border rows and columns were zeroed by PreProcessing.
+  if (options_.stencil != SobelStencil::kSobel) {
+    StencilGrayRowsOf(options_.stencil, gray, w, h - (2 * radius), interior);
+  } else if (options_.traversal == SobelTraversal::kTiles) {
+    const SobelTileGrid grid(w, h - 2, options_);
+    for (std::size_t i = 0; i < grid.Count(); ++i) {
+      SobelTileRows(gray, interior, w, grid.Tile(i));
     }
+  } else if constexpr (!kIsU8Pixel<Pixel>) {
+    SobelGrayRowsOf(gray, w, h - 2, interior);
+  } else if (!FusedGray()) {
+    SobelRows(options_.kernel, separable_, gray, w, h - 2, interior);
+  } else if (in.channels == 1) {
+    SobelRows(options_.kernel, separable_, in.Row(0), w, h - 2, interior, in.RowPitch());
+  } else {
+    fused_.Process(options_.kernel, in.Row(0), in.channels, w, h - 2, interior, in.RowPitch());
   }
 
   return true;
 }
 
-bool SobelEdgeDetectionSEQ::PostProcessingImpl() {
-  auto &out = GetOutput();
-  out.data = out_data_;
+template <typename Pixel>
+bool BasicSobelEdgeDetectionSEQ<Pixel>::FusedGray() {
+  return kIsU8Pixel<Pixel> && options_.stencil == SobelStencil::kSobel && options_.gray == SobelGrayMode::kFused &&
+         options_.traversal == SobelTraversal::kRows && this->GetInput().layout == PixelLayout::kInterleaved;
+}
+
+template <typename Pixel>
+bool BasicSobelEdgeDetectionSEQ<Pixel>::PostProcessingImpl() {
+  auto &out = this->GetOutput();
+  workspace_.LendOut(out.data);
   return (out.data.size() == out.width * out.height * out.channels);
 }
 
+template class BasicSobelEdgeDetectionSEQ<uint8_t>;
+template class BasicSobelEdgeDetectionSEQ<uint16_t>;
+template class BasicSobelEdgeDetectionSEQ<float>;
+
 }  // namespace rychkova_d_sobel_edge_detection
@@ -0,0 +1,216 @@
+#include "rychkova_d_sobel_edge_detection/seq/include/ops_seq_file.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "rychkova_d_sobel_edge_detection/common/include/common.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_frame.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_stencil.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_tiles.hpp"
+
+namespace rychkova_d_sobel_edge_detection {
+
+namespace {
+
+// Reads the next header field of a PNM file, skipping whitespace and '#' comments up to the end of their line.
+bool ReadPnmField(std::istream &in, std::string &field) {
+  field.clear();
+  int c = in.get();
+  while (c != std::char_traits<char>::eof()) {
+    if (c == '#') {
+      while (c != std::char_traits<char>::eof() && c != '\n') {
+        c = in.get();
+      }
+    } else if (std::isspace(c) == 0) {
+      break;
+    }
+    c = in.get();
+  }
+  while (c != std::char_traits<char>::eof() && std::isspace(c) == 0) {
+    field.push_back(static_cast<char>(c));
+    c = in.get();
+  }
+  // The single whitespace character that ended the field is consumed, as PNM requires after maxval.
+  return !field.empty();
+}
+
+bool ParseSize(const std::string &field, std::size_t &value) {
+  const auto is_digit = [](char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; };
+  if (field.empty() || !std::ranges::all_of(field, is_digit)) {
+    return false;
+  }
+  value = std::stoull(field);
+  return true;
+}
+
+// Fills the geometry of a PNM file from its header and returns the offset of the pixel data.
+bool ReadPnmHeader(const std::string &path, ImageFile &layout, std::size_t &data_offset) {
+  std::ifstream in(path, std::ios::binary);
+  std::string magic;
+  std::string width;
+  std::string height;
+  std::string maxval;
+  if (!ReadPnmField(in, magic) || !ReadPnmField(in, width) || !ReadPnmField(in, height) ||
+      !ReadPnmField(in, maxval)) {
+    return false;
+  }
+  if (magic == "P5") {
+    layout.channels = 1;
+  } else if (magic == "P6") {
+    layout.channels = 3;
+  } else {
+    return false;
+  }
+  // Only 8-bit samples are supported.
+  if (maxval != "255" || !ParseSize(width, layout.width) || !ParseSize(height, layout.height)) {
+    return false;
+  }
+  data_offset = static_cast<std::size_t>(in.tellg());
+  return true;
+}
+
+bool ReadRows(std::istream &in, uint8_t *dst, std::size_t bytes) {
+  in.read(reinterpret_cast<char *>(dst), static_cast<std::streamsize>(bytes));
+  return static_cast<std::size_t>(in.gcount()) == bytes;
+}
+
+std::string OutputHeader(const ImageFile &file) {
+  if (file.format != ImageFileFormat::kPnm) {
+    return {};
+  }
+  return "P5\n" + std::to_string(file.width) + ' ' + std::to_string(file.height) + "\n255\n";
+}
+
+void WriteRows(std::ostream &out, const uint8_t *src, std::size_t bytes) {
+  out.write(reinterpret_cast<const char *>(src), static_cast<std::streamsize>(bytes));
+}
+
+}  // namespace
+
+SobelFileSEQ::SobelFileSEQ(ImageFileJob in, SobelOptions options) : options_(options) {
+  SetTypeOfTask(GetStaticTypeOfTask());
+  GetInput() = std::move(in);
+  GetOutput() = ImageFile{};
+}
+
+bool SobelFileSEQ::ValidationImpl() {
+  const auto &in = GetInput();
+  if (!ValidTiling(options_) || options_.strip_rows == 0) {
+    return false;
+  }
+  if (in.output_path.empty() || in.output_path == in.input.path) {
+    return false;
+  }
+
+  layout_ = in.input;
+  data_offset_ = 0;
+  if (in.input.format == ImageFileFormat::kPnm && !ReadPnmHeader(in.input.path, layout_, data_offset_)) {
+    return false;
+  }
+  if (layout_.width == 0 || layout_.height == 0) {
+    return false;
+  }
+  if (layout_.channels != 1 && layout_.channels != 3) {
+    return false;
+  }
+
+  std::error_code ec;
+  const auto file_size = std::filesystem::file_size(in.input.path, ec);
+  if (ec || file_size < data_offset_ + (layout_.width * layout_.height * layout_.channels)) {
+    return false;
+  }
+
+  const auto &out = GetOutput();
+  return out.path.empty() && out.width == 0 && out.height == 0;
+}
+
+bool SobelFileSEQ::PreProcessingImpl() {
+  const std::size_t w = layout_.width;
+  const std::size_t strip = std::min(options_.strip_rows, layout_.height);
+  raw_.assign((strip + (2 * StencilRadius(options_.stencil))) * w * layout_.channels, 0);
+  // Border columns of the output strip are never written and stay zero from here on.
+  out_.assign(strip * w, 0);
+  zero_row_.assign(w, 0);
+
+  auto &out = GetOutput();
+  out.path = GetInput().output_path;
+  out.format = layout_.format;
+  out.width = w;
+  out.height = layout_.height;
+  out.channels = 1;
+  return true;
+}
+
+bool SobelFileSEQ::RunImpl() {
+  const std::size_t w = layout_.width;
+  const std::size_t h = layout_.height;
+  const std::size_t ch = layout_.channels;
+  const std::size_t row_bytes = w * ch;
+  const std::size_t radius = StencilRadius(options_.stencil);
+  const std::size_t halo = 2 * radius;
+
+  std::ifstream in(GetInput().input.path, std::ios::binary);
+  std::ofstream out(GetOutput().path, std::ios::binary | std::ios::trunc);
+  if (!in || !out) {
+    return false;
+  }
+  in.seekg(static_cast<std::streamoff>(data_offset_));
+  out << OutputHeader(GetOutput());
+
+  if (w <= halo || h <= halo) {
+    for (std::size_t y = 0; y < h; ++y) {
+      WriteRows(out, zero_row_.data(), w);
+    }
+    return out.good();
+  }
+
+  for (std::size_t y = 0; y < radius; ++y) {
+    WriteRows(out, zero_row_.data(), w);
+  }
+  // raw_ always starts radius rows above the next output row: image rows y - radius .. y + rows + radius - 1 for a
+  // strip of rows.
+  const std::size_t strip = out_.size() / w;
+  if (!ReadRows(in, raw_.data(), std::min(h, strip + halo) * row_bytes)) {
+    return false;
+  }
+  std::size_t y = radius;
+  while (true) {
+    const std::size_t rows = std::min(strip, h - radius - y);
+    SobelWindow(options_, raw_.data(), ch, w, rows, scratch_, out_.data());
+    WriteRows(out, out_.data(), rows * w);
+    y += rows;
+    if (y + radius >= h) {
+      break;
+    }
+    // The last 2 * radius rows held are the halo above the next strip; only its own rows and the radius rows below
+    // it are read.
+    std::copy(raw_.begin() + static_cast<std::ptrdiff_t>(rows * row_bytes),
+              raw_.begin() + static_cast<std::ptrdiff_t>((rows + halo) * row_bytes), raw_.begin());
+    const std::size_t next = std::min(strip, h - radius - y);
+    if (!ReadRows(in, raw_.data() + (halo * row_bytes), next * row_bytes)) {
+      return false;
+    }
+  }
+  for (std::size_t k = 0; k < radius; ++k) {
+    WriteRows(out, zero_row_.data(), w);
+  }
+  return out.good();
+}
+
+bool SobelFileSEQ::PostProcessingImpl() {
+  const auto &out = GetOutput();
+  std::error_code ec;
+  const auto file_size = std::filesystem::file_size(out.path, ec);
+  return !ec && file_size == OutputHeader(out).size() + (out.width * out.height);
+}
+
+}  // namespace rychkova_d_sobel_edge_detection
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <barrier>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "rychkova_d_sobel_edge_detection/common/include/common.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_workspace.hpp"
+#include "task/include/task.hpp"
+
+namespace rychkova_d_sobel_edge_detection {
+
+/// @brief Fixed set of std::thread workers that are started once and reused for every job.
+/// @details The calling thread acts as worker 0, so a pool of N workers spawns N - 1 threads.
+///          Start and completion are synchronized with a pair of std::barrier objects. Jobs are passed by reference
+///          and called through a function pointer, so a Run allocates nothing whatever the job captures.
+class SobelWorkerPool {
+ public:
+  explicit SobelWorkerPool(std::size_t num_workers);
+  ~SobelWorkerPool();
+
+  SobelWorkerPool(const SobelWorkerPool &) = delete;
+  SobelWorkerPool &operator=(const SobelWorkerPool &) = delete;
+  SobelWorkerPool(SobelWorkerPool &&) = delete;
+  SobelWorkerPool &operator=(SobelWorkerPool &&) = delete;
+
+  [[nodiscard]] std::size_t Size() const {
+    return num_workers_;
+  }
+
+  /// @brief Runs @p job(worker, num_workers) on every worker and returns once all of them have finished.
+  template <typename Job>
+  void Run(const Job &job) {
+    job_ = &job;
+    invoke_ = [](const void *erased, std::size_t worker, std::size_t num_workers) {
+      (*static_cast<const Job *>(erased))(worker, num_workers);
+    };
+    RunJob();
+  }
+
+ private:
+  using Invoke = void (*)(const void *job, std::size_t worker, std::size_t num_workers);
+
+  /// @brief Releases the workers on the current job, runs it as worker 0 and waits for the others.
+  void RunJob();
+  void WorkerLoop(std::size_t worker);
+
+  std::size_t num_workers_;
+  const void *job_ = nullptr;
+  Invoke invoke_ = nullptr;
+  bool stop_ = false;
+  std::barrier<> start_;
+  std::barrier<> done_;
+  std::vector<std::thread> threads_;
+};
+
+class SobelEdgeDetectionSTL : public BaseTask {
+ public:
+  static constexpr ppc::task::TypeOfTask GetStaticTypeOfTask() {
+    return ppc::task::TypeOfTask::kSTL;
+  }
+
+  explicit SobelEdgeDetectionSTL(InType in, SobelOptions options = {});
+
+ private:
+  bool ValidationImpl() override;
+  bool PreProcessingImpl() override;
+  bool RunImpl() override;
+  bool PostProcessingImpl() override;
+
+  SobelWorkspace workspace_;
+  SobelOptions options_;
+  std::unique_ptr<SobelWorkerPool> pool_;
+};
+
+}  // namespace rychkova_d_sobel_edge_detection
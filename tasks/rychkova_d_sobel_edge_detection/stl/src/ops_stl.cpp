@@ -0,0 +1,189 @@
+#include "rychkova_d_sobel_edge_detection/stl/include/ops_stl.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include "rychkova_d_sobel_edge_detection/common/include/common.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_gray.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_kernel.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_pixel.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_stencil.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_tiles.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_workspace.hpp"
+#include "util/include/util.hpp"
+
+namespace rychkova_d_sobel_edge_detection {
+
+namespace {
+
+// Static block partition of [begin, end) into num_parts contiguous pieces, the first `rem` one element longer.
+std::pair<std::size_t, std::size_t> StaticChunk(std::size_t begin, std::size_t end, std::size_t part,
+                                                std::size_t num_parts) {
+  const std::size_t total = end - begin;
+  const std::size_t base = total / num_parts;
+  const std::size_t rem = total % num_parts;
+  const std::size_t first = begin + (base * part) + std::min(part, rem);
+  const std::size_t count = base + (part < rem ? 1 : 0);
+  return {first, first + count};
+}
+
+}  // namespace
+
+SobelWorkerPool::SobelWorkerPool(std::size_t num_workers)
+    : num_workers_(std::max<std::size_t>(num_workers, 1)),
+      start_(static_cast<std::ptrdiff_t>(num_workers_)),
+      done_(static_cast<std::ptrdiff_t>(num_workers_)) {
+  threads_.reserve(num_workers_ - 1);
+  for (std::size_t worker = 1; worker < num_workers_; ++worker) {
+    threads_.emplace_back([this, worker] { WorkerLoop(worker); });
+  }
+}
+
+SobelWorkerPool::~SobelWorkerPool() {
+  stop_ = true;
+  start_.arrive_and_wait();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+void SobelWorkerPool::RunJob() {
+  start_.arrive_and_wait();
+  invoke_(job_, 0, num_workers_);
+  done_.arrive_and_wait();
+  job_ = nullptr;
+  invoke_ = nullptr;
+}
+
+void SobelWorkerPool::WorkerLoop(std::size_t worker) {
+  while (true) {
+    start_.arrive_and_wait();
+    if (stop_) {
+      return;
+    }
+    invoke_(job_, worker, num_workers_);
+    done_.arrive_and_wait();
+  }
+}
+
+SobelEdgeDetectionSTL::SobelEdgeDetectionSTL(InType in, SobelOptions options) : options_(options) {
+  SetTypeOfTask(GetStaticTypeOfTask());
+  GetInput() = std::move(in);
+  GetOutput() = OutType{};
+}
+
+bool SobelEdgeDetectionSTL::ValidationImpl() {
+  const auto &in = GetInput();
+  if (in.width == 0 || in.height == 0) {
+    return false;
+  }
+  if (!ValidPixelFormat(in.channels, in.layout)) {
+    return false;
+  }
+  if (!ValidTiling(options_)) {
+    return false;
+  }
+
+  if (!ValidImageBuffer(in)) {
+    return false;
+  }
+
+  const auto &out = GetOutput();
+  return out.data.empty() && out.width == 0 && out.height == 0;
+}
+
+bool SobelEdgeDetectionSTL::PreProcessingImpl() {
+  const auto &in = GetInput();
+
+  const auto num_threads = static_cast<std::size_t>(std::max(ppc::util::GetNumThreads(), 1));
+  if (!pool_ || pool_->Size() != num_threads) {
+    pool_.reset();
+    pool_ = std::make_unique<SobelWorkerPool>(num_threads);
+  }
+
+  const std::size_t pixels = in.width * in.height;
+  auto &out = GetOutput();
+  workspace_.PrepareOut(out.data, in.width, in.height, StencilRadius(options_.stencil));
+
+  // Colour -> grayscale in any layout; a plain copy for single-channel input
+  uint8_t *dst = workspace_.PrepareGray(pixels);
+  pool_->Run([&in, dst, pixels](std::size_t worker, std::size_t num_workers) {
+    const auto [begin, end] = StaticChunk(0, pixels, worker, num_workers);
+    GrayPixels(in, dst, begin, end);
+  });
+
+  out.width = in.width;
+  out.height = in.height;
+  out.channels = 1;
+
+  return true;
+}
+
+bool SobelEdgeDetectionSTL::RunImpl() {
+  const auto &in = GetInput();
+  const std::size_t w = in.width;
+  const std::size_t h = in.height;
+
+  if (w == 0 || h == 0) {
+    return false;
+  }
+
+  const std::size_t radius = StencilRadius(options_.stencil);
+  if (w <= 2 * radius || h <= 2 * radius) {
+    std::fill(workspace_.out.begin(), workspace_.out.end(), 0);
+    return true;
+  }
+
+  const uint8_t *gray = workspace_.gray.data();
+  uint8_t *out = workspace_.out.data();
+
+  if (options_.stencil != SobelStencil::kSobel) {
+    const SobelStencil stencil = options_.stencil;
+    uint8_t *interior = out + (radius * w);
+    pool_->Run([stencil, gray, interior, w, rows = h - (2 * radius)](std::size_t worker, std::size_t num_workers) {
+      const auto [row_begin, row_end] = StaticChunk(0, rows, worker, num_workers);
+      StencilGrayRowsOf(stencil, gray + (row_begin * w), w, row_end - row_begin, interior + (row_begin * w));
+    });
+    return true;
+  }
+
+  if (options_.traversal == SobelTraversal::kTiles) {
+    const SobelTileGrid grid(w, h - 2, options_);
+    uint8_t *interior = out + w;
+
+    // Every worker takes a contiguous run of tiles, i.e. whole bands of rows where possible.
+    pool_->Run([&grid, gray, interior, w](std::size_t worker, std::size_t num_workers) {
+      const auto [tile_begin, tile_end] = StaticChunk(0, grid.Count(), worker, num_workers);
+      for (std::size_t i = tile_begin; i < tile_end; ++i) {
+        SobelTileRows(gray, interior, w, grid.Tile(i));
+      }
+    });
+    return true;
+  }
+
+  pool_->Run([gray, out, w, h](std::size_t worker, std::size_t num_workers) {
+    const auto [row_begin, row_end] = StaticChunk(1, h - 1, worker, num_workers);
+    for (std::size_t y = row_begin; y < row_end; ++y) {
+      const uint8_t *above = gray + ((y - 1) * w);
+      const uint8_t *row = gray + (y * w);
+      const uint8_t *below = gray + ((y + 1) * w);
+      uint8_t *dst = out + (y * w);
+
+      SobelRow(above, row, below, dst, 1, w - 1);
+    }
+  });
+
+  return true;
+}
+
+bool SobelEdgeDetectionSTL::PostProcessingImpl() {
+  auto &out = GetOutput();
+  workspace_.LendOut(out.data);
+  return (out.data.size() == out.width * out.height * out.channels);
+}
+
+}  // namespace rychkova_d_sobel_edge_detection
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "oneapi/tbb/enumerable_thread_specific.h"
+#include "rychkova_d_sobel_edge_detection/common/include/common.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_frame.hpp"
+#include "task/include/task.hpp"
+
+namespace rychkova_d_sobel_edge_detection {
+
+/// @brief Sobel over a stream of frames, pipelined with a TBB parallel_pipeline for sustained frames/s.
+/// @details Frames move through bounded stages (take frame -> grayscale -> edge pass -> write output), so the gray
+///          conversion of frame N + 1 runs next to the edge pass of frame N and the output write of frame N - 1.
+///          Every frame yields the same image as SobelEdgeDetectionSEQ with the same options.
+class SobelStreamTBB : public ppc::task::Task<FrameStream, FrameStream> {
+ public:
+  static constexpr ppc::task::TypeOfTask GetStaticTypeOfTask() {
+    return ppc::task::TypeOfTask::kTBB;
+  }
+
+  explicit SobelStreamTBB(FrameStream in, SobelOptions options = {});
+
+ private:
+  bool ValidationImpl() override;
+  bool PreProcessingImpl() override;
+  bool RunImpl() override;
+  bool PostProcessingImpl() override;
+
+  // One grayscale buffer per pipeline token; frame i always uses slot i % depth_.
+  std::vector<PixelBuffer<uint8_t>> gray_slots_;
+  // Scratch rows of the edge pass, one per TBB worker, kept from run to run.
+  tbb::enumerable_thread_specific<SobelFrameScratch> scratches_;
+  FrameStream out_frames_;
+  std::size_t depth_ = 1;
+  SobelOptions options_;
+};
+
+}  // namespace rychkova_d_sobel_edge_detection
@@ -0,0 +1,144 @@
+#include "rychkova_d_sobel_edge_detection/tbb/include/ops_tbb.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "oneapi/tbb/blocked_range.h"
+#include "oneapi/tbb/blocked_range2d.h"
+#include "oneapi/tbb/parallel_for.h"
+#include "oneapi/tbb/partitioner.h"
+#include "rychkova_d_sobel_edge_detection/common/include/common.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_gray.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_kernel.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_pixel.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_stencil.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_tiles.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_workspace.hpp"
+
+namespace rychkova_d_sobel_edge_detection {
+
+namespace {
+
+// Minimal tile extents handed to a single TBB task; smaller tiles are not split further.
+constexpr std::size_t kTileRowGrain = 32;
+constexpr std::size_t kTileColGrain = 256;
+constexpr std::size_t kGrayGrain = 16384;
+
+}  // namespace
+
+SobelEdgeDetectionTBB::SobelEdgeDetectionTBB(InType in, SobelOptions options) : options_(options) {
+  SetTypeOfTask(GetStaticTypeOfTask());
+  GetInput() = std::move(in);
+  GetOutput() = OutType{};
+}
+
+bool SobelEdgeDetectionTBB::ValidationImpl() {
+  const auto &in = GetInput();
+  if (in.width == 0 || in.height == 0) {
+    return false;
+  }
+  if (!ValidPixelFormat(in.channels, in.layout)) {
+    return false;
+  }
+  if (!ValidTiling(options_)) {
+    return false;
+  }
+
+  if (!ValidImageBuffer(in)) {
+    return false;
+  }
+
+  const auto &out = GetOutput();
+  return out.data.empty() && out.width == 0 && out.height == 0;
+}
+
+bool SobelEdgeDetectionTBB::PreProcessingImpl() {
+  const auto &in = GetInput();
+
+  const std::size_t pixels = in.width * in.height;
+  auto &out = GetOutput();
+  workspace_.PrepareOut(out.data, in.width, in.height, StencilRadius(options_.stencil));
+
+  // Colour -> grayscale in any layout; a plain copy for single-channel input
+  uint8_t *dst = workspace_.PrepareGray(pixels);
+  tbb::parallel_for(tbb::blocked_range<std::size_t>(0, pixels, kGrayGrain),
+                    [&in, dst](const tbb::blocked_range<std::size_t> &range) {
+    GrayPixels(in, dst, range.begin(), range.end());
+  });
+
+  out.width = in.width;
+  out.height = in.height;
+  out.channels = 1;
+
+  return true;
+}
+
+bool SobelEdgeDetectionTBB::RunImpl() {
+  const auto &in = GetInput();
+  const std::size_t w = in.width;
+  const std::size_t h = in.height;
+
+  if (w == 0 || h == 0) {
+    return false;
+  }
+
+  const std::size_t radius = StencilRadius(options_.stencil);
+  if (w <= 2 * radius || h <= 2 * radius) {
+    std::fill(workspace_.out.begin(), workspace_.out.end(), 0);
+    return true;
+  }
+
+  const uint8_t *gray = workspace_.gray.data();
+  uint8_t *out = workspace_.out.data();
+
+  if (options_.stencil != SobelStencil::kSobel) {
+    const SobelStencil stencil = options_.stencil;
+    uint8_t *interior = out + (radius * w);
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, h - (2 * radius), kTileRowGrain),
+                      [stencil, gray, interior, w](const tbb::blocked_range<std::size_t> &range) {
+      StencilGrayRowsOf(stencil, gray + (range.begin() * w), w, range.size(), interior + (range.begin() * w));
+    });
+    return true;
+  }
+
+  if (options_.traversal == SobelTraversal::kTiles) {
+    // The configured tile extents become the grain sizes; simple_partitioner splits every range down to them.
+    const tbb::blocked_range2d<std::size_t> tiles(0, h - 2, options_.tile_height, 1, w - 1, options_.tile_width);
+    uint8_t *interior = out + w;
+
+    tbb::parallel_for(tiles, [gray, interior, w](const tbb::blocked_range2d<std::size_t> &range) {
+      const SobelTile tile{.y_begin = range.rows().begin(),
+                           .y_end = range.rows().end(),
+                           .x_begin = range.cols().begin(),
+                           .x_end = range.cols().end()};
+      SobelTileRows(gray, interior, w, tile);
+    }, tbb::simple_partitioner());
+    return true;
+  }
+
+  // Tiles cover the interior only; the one-pixel border stays zero from PreProcessing.
+  const tbb::blocked_range2d<std::size_t> interior(1, h - 1, kTileRowGrain, 1, w - 1, kTileColGrain);
+
+  tbb::parallel_for(interior, [gray, out, w](const tbb::blocked_range2d<std::size_t> &tile) {
+    for (std::size_t y = tile.rows().begin(); y != tile.rows().end(); ++y) {
+      const uint8_t *above = gray + ((y - 1) * w);
+      const uint8_t *row = gray + (y * w);
+      const uint8_t *below = gray + ((y + 1) * w);
+      uint8_t *dst = out + (y * w);
+
+      SobelRow(above, row, below, dst, tile.cols().begin(), tile.cols().end());
+    }
+  });
+
+  return true;
+}
+
+bool SobelEdgeDetectionTBB::PostProcessingImpl() {
+  auto &out = GetOutput();
+  workspace_.LendOut(out.data);
+  return (out.data.size() == out.width * out.height * out.channels);
+}
+
+}  // namespace rychkova_d_sobel_edge_detection
@@ -0,0 +1,147 @@
+#include "rychkova_d_sobel_edge_detection/tbb/include/ops_tbb_stream.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "oneapi/tbb/parallel_pipeline.h"
+#include "rychkova_d_sobel_edge_detection/common/include/common.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_frame.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_gray.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_stencil.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_workspace.hpp"
+#include "util/include/util.hpp"
+
+namespace rychkova_d_sobel_edge_detection {
+
+namespace {
+
+// A frame on its way through the pipeline.
+struct FrameToken {
+  std::size_t index = 0;
+  const uint8_t *src = nullptr;  // gray frame, or the input itself when no gray frame is built
+  std::size_t src_channels = 1;
+  PixelBuffer<uint8_t> out;
+};
+
+// Whether the gray stage writes a gray frame for @p frame; strided frames are repacked there whatever the options.
+bool BuildsGrayFrame(const SobelOptions &options, const Image &frame) {
+  return !frame.Packed() || NeedsGrayFrame(options, frame.channels, frame.layout);
+}
+
+}  // namespace
+
+SobelStreamTBB::SobelStreamTBB(FrameStream in, SobelOptions options) : options_(options) {
+  SetTypeOfTask(GetStaticTypeOfTask());
+  GetInput() = std::move(in);
+  GetOutput() = FrameStream{};
+}
+
+bool SobelStreamTBB::ValidationImpl() {
+  if (!ValidTiling(options_)) {
+    return false;
+  }
+  for (const auto &frame : GetInput()) {
+    if (frame.width == 0 || frame.height == 0) {
+      return false;
+    }
+    if (!ValidPixelFormat(frame.channels, frame.layout)) {
+      return false;
+    }
+    if (!ValidImageBuffer(frame)) {
+      return false;
+    }
+  }
+  return GetOutput().empty();
+}
+
+bool SobelStreamTBB::PreProcessingImpl() {
+  const auto &in = GetInput();
+
+  depth_ = options_.stream_depth != 0 ? options_.stream_depth
+                                      : 2 * static_cast<std::size_t>(std::max(ppc::util::GetNumThreads(), 1));
+  depth_ = std::max<std::size_t>(1, std::min(depth_, in.size()));
+
+  // Gray slots are sized for the largest frame once, so Run never allocates them again; they, like the output frames
+  // taken back from the previous run, only ever grow.
+  std::size_t max_pixels = 0;
+  for (const auto &frame : in) {
+    if (BuildsGrayFrame(options_, frame)) {
+      max_pixels = std::max(max_pixels, frame.width * frame.height);
+    }
+  }
+  gray_slots_.resize(std::max(gray_slots_.size(), max_pixels != 0 ? depth_ : 0));
+  for (auto &slot : gray_slots_) {
+    slot.resize(std::max(slot.size(), max_pixels));
+  }
+
+  out_frames_ = std::move(GetOutput());
+  GetOutput().clear();
+  out_frames_.resize(in.size());
+  return true;
+}
+
+bool SobelStreamTBB::RunImpl() {
+  const auto &in = GetInput();
+  if (in.empty()) {
+    return true;
+  }
+
+  std::size_t next = 0;
+
+  // Take frame: hands out frame indices in order; depth_ tokens bound the frames (and gray slots) in flight.
+  auto take = tbb::make_filter<void, FrameToken>(tbb::filter_mode::serial_in_order, [&](tbb::flow_control &fc) {
+    if (next == in.size()) {
+      fc.stop();
+      return FrameToken{};
+    }
+    return FrameToken{.index = next++, .src = nullptr, .src_channels = 1, .out = {}};
+  });
+
+  // Grayscale: builds the gray frame when the edge stage reads one.
+  auto gray = tbb::make_filter<FrameToken, FrameToken>(tbb::filter_mode::parallel, [&](FrameToken token) {
+    const Image &frame = in[token.index];
+    if (BuildsGrayFrame(options_, frame)) {
+      uint8_t *slot = gray_slots_[token.index % depth_].data();
+      GrayPixels(frame, slot, 0, frame.width * frame.height);
+      token.src = slot;
+      token.src_channels = 1;
+    } else {
+      token.src = frame.data.data();
+      token.src_channels = frame.channels;
+    }
+    return token;
+  });
+
+  // Edge pass, run by TBB workers on several in-flight frames at once: each token reclaims its frame's output buffer
+  // from the previous run, zeroes the border and filters the frame the gray stage left single-channel if needed.
+  auto edge = tbb::make_filter<FrameToken, FrameToken>(tbb::filter_mode::parallel, [&](FrameToken token) {
+    const Image &frame = in[token.index];
+    token.out.swap(out_frames_[token.index].data);
+    token.out.resize(frame.width * frame.height);
+    ZeroBorder(token.out.data(), frame.width, frame.height, StencilRadius(options_.stencil));
+    SobelFrame(options_, token.src, token.src_channels, frame.width, frame.height, scratches_.local(),
+               token.out.data());
+    return token;
+  });
+
+  // Write output: frames leave in input order.
+  auto write = tbb::make_filter<FrameToken, void>(tbb::filter_mode::serial_in_order, [&](FrameToken token) {
+    const Image &frame = in[token.index];
+    out_frames_[token.index] =
+        Image{.data = std::move(token.out), .width = frame.width, .height = frame.height, .channels = 1};
+  });
+
+  tbb::parallel_pipeline(depth_, take & gray & edge & write);
+  return true;
+}
+
+bool SobelStreamTBB::PostProcessingImpl() {
+  auto &out = GetOutput();
+  out = std::move(out_frames_);
+  return out.size() == GetInput().size();
+}
+
+}  // namespace rychkova_d_sobel_edge_detection
@@ -1,16 +1,36 @@
 #include <gtest/gtest.h>
+#include <libenvpp/detail/get.hpp>
+#include <mpi.h>
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
 #include <string>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "rychkova_d_sobel_edge_detection/all/include/ops_all.hpp"
 #include "rychkova_d_sobel_edge_detection/common/include/common.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_gray.hpp"
+#include "rychkova_d_sobel_edge_detection/common/include/sobel_kernel.hpp"
 #include "rychkova_d_sobel_edge_detection/mpi/include/ops_mpi.hpp"
+#include "rychkova_d_sobel_edge_detection/omp/include/ops_omp.hpp"
+#include "rychkova_d_sobel_edge_detection/omp/include/ops_omp_batch.hpp"
 #include "rychkova_d_sobel_edge_detection/seq/include/ops_seq.hpp"
+#include "rychkova_d_sobel_edge_detection/seq/include/ops_seq_file.hpp"
+#include "rychkova_d_sobel_edge_detection/stl/include/ops_stl.hpp"
+#include "rychkova_d_sobel_edge_detection/tbb/include/ops_tbb.hpp"
+#include "rychkova_d_sobel_edge_detection/tbb/include/ops_tbb_stream.hpp"
 #include "util/include/func_test_util.hpp"
 #include "util/include/util.hpp"
 
@@ -176,17 +196,98 @@ TEST_P(RychkovaDRunFuncTestsSobel, SobelFromGeneratedImage) {
   ExecuteTest(GetParam());
 }
 
-const std::array<TestType, 5> kTestParam = {
+const std::array<TestType, 6> kTestParam = {
     RychkovaDRunFuncTestsSobel::ParamPattern(2, 2, 1, "gray_2x2_pattern"),
     RychkovaDRunFuncTestsSobel::ParamConst(8, 6, 1, 128, "gray_const_8x6_128"),
     RychkovaDRunFuncTestsSobel::ParamPattern(19, 11, 1, "gray_19x11_pattern"),
     RychkovaDRunFuncTestsSobel::ParamPattern(16, 9, 3, "rgb_16x9_pattern"),
     RychkovaDRunFuncTestsSobel::ParamPattern(32, 32, 1, "gray_32x32_pattern"),
+    RychkovaDRunFuncTestsSobel::ParamPattern(600, 70, 3, "rgb_600x70_pattern"),
 };
 
+template <typename TaskType, std::size_t... Is>
+auto GenOptionsTaskTuplesImpl(const std::array<TestType, sizeof...(Is)> &params, const std::string &settings_path,
+                              SobelOptions options, const std::string &mode_name,
+                              std::index_sequence<Is...> /*unused*/) {
+  const std::string name = ppc::util::GetNamespace<TaskType>() + "_" +
+                           ppc::task::GetStringTaskType(TaskType::GetStaticTypeOfTask(), settings_path) + "_" +
+                           mode_name;
+  const std::function<ppc::task::TaskPtr<InType, OutType>(InType)> getter =
+      [options](InType in) -> ppc::task::TaskPtr<InType, OutType> {
+    return std::make_shared<TaskType>(std::move(in), options);
+  };
+  return std::make_tuple(std::make_tuple(getter, name, params[Is])...);
+}
+
+/// @brief Same as ppc::util::AddFuncTask, but constructs every task with @p options and tags it with @p mode_name.
+template <typename TaskType, std::size_t N>
+auto AddFuncTaskWithOptions(const std::array<TestType, N> &params, const std::string &settings_path,
+                            SobelOptions options, const std::string &mode_name) {
+  return GenOptionsTaskTuplesImpl<TaskType>(params, settings_path, options, mode_name, std::make_index_sequence<N>{});
+}
+
+const SobelOptions kSeparable{.kernel = SobelKernelMode::kSeparable};
+const SobelOptions kFused{.gray = SobelGrayMode::kFused};
+const SobelOptions kFusedSeparable{.kernel = SobelKernelMode::kSeparable, .gray = SobelGrayMode::kFused};
+const SobelOptions kExchange{.halo = SobelHaloMode::kExchange};
+const SobelOptions kFusedExchange{.gray = SobelGrayMode::kFused, .halo = SobelHaloMode::kExchange};
+const SobelOptions kOverlap{.comm = SobelCommMode::kOverlapped};
+// More pieces than the small test strips have rows, so some pieces are empty.
+const SobelOptions kFusedOverlap{.gray = SobelGrayMode::kFused, .comm = SobelCommMode::kOverlapped, .comm_blocks = 9};
+const SobelOptions kRowStrips{.decomposition = SobelDecomposition::kRows};
+const SobelOptions kBlocks{.decomposition = SobelDecomposition::kBlocks};
+const SobelOptions kShared{.transport = SobelTransport::kSharedWindow};
+const SobelOptions kFusedShared{.gray = SobelGrayMode::kFused, .transport = SobelTransport::kSharedWindow};
+// Deliberately tiny and non-dividing tiles so every test image has partial tiles on both axes.
+const SobelOptions kTiled{.traversal = SobelTraversal::kTiles, .tile_width = 7, .tile_height = 3};
+
 const auto kTestTasksList = std::tuple_cat(
+    ppc::util::AddFuncTask<SobelEdgeDetectionALL, InType>(kTestParam, PPC_SETTINGS_rychkova_d_sobel_edge_detection),
     ppc::util::AddFuncTask<SobelEdgeDetectionMPI, InType>(kTestParam, PPC_SETTINGS_rychkova_d_sobel_edge_detection),
-    ppc::util::AddFuncTask<SobelEdgeDetectionSEQ, InType>(kTestParam, PPC_SETTINGS_rychkova_d_sobel_edge_detection));
+    ppc::util::AddFuncTask<SobelEdgeDetectionOMP, InType>(kTestParam, PPC_SETTINGS_rychkova_d_sobel_edge_detection),
+    ppc::util::AddFuncTask<SobelEdgeDetectionSEQ, InType>(kTestParam, PPC_SETTINGS_rychkova_d_sobel_edge_detection),
+    ppc::util::AddFuncTask<SobelEdgeDetectionSTL, InType>(kTestParam, PPC_SETTINGS_rychkova_d_sobel_edge_detection),
+    ppc::util::AddFuncTask<SobelEdgeDetectionTBB, InType>(kTestParam, PPC_SETTINGS_rychkova_d_sobel_edge_detection),
+    AddFuncTaskWithOptions<SobelEdgeDetectionMPI>(kTestParam, PPC_SETTINGS_rychkova_d_sobel_edge_detection, kSeparable,
+                                                  "separable"),
+    AddFuncTaskWithOptions<SobelEdgeDetectionSEQ>(kTestParam, PPC_SETTINGS_rychkova_d_sobel_edge_detection, kSeparable,
+                                                  "separable"),
+    AddFuncTaskWithOptions<SobelEdgeDetectionMPI>(kTestParam, PPC_SETTINGS_rychkova_d_sobel_edge_detection, kFused,
+                                                  "fused"),
+    AddFuncTaskWithOptions<SobelEdgeDetectionSEQ>(kTestParam, PPC_SETTINGS_rychkova_d_sobel_edge_detection, kFused,
+                                                  "fused"),
+    AddFuncTaskWithOptions<SobelEdgeDetectionMPI>(kTestParam, PPC_SETTINGS_rychkova_d_sobel_edge_detection,
+                                                  kFusedSeparable, "fused_separable"),
+    AddFuncTaskWithOptions<SobelEdgeDetectionSEQ>(kTestParam, PPC_SETTINGS_rychkova_d_sobel_edge_detection,
+                                                  kFusedSeparable, "fused_separable"),
+    AddFuncTaskWithOptions<SobelEdgeDetectionMPI>(kTestParam, PPC_SETTINGS_rychkova_d_sobel_edge_detection, kExchange,
+                                                  "exchange"),
+    AddFuncTaskWithOptions<SobelEdgeDetectionMPI>(kTestParam, PPC_SETTINGS_rychkova_d_sobel_edge_detection,
+                                                  kFusedExchange, "fused_exchange"),
+    AddFuncTaskWithOptions<SobelEdgeDetectionMPI>(kTestParam, PPC_SETTINGS_rychkova_d_sobel_edge_detection, kOverlap,
+                                                  "overlap"),
+    AddFuncTaskWithOptions<SobelEdgeDetectionMPI>(kTestParam, PPC_SETTINGS_rychkova_d_sobel_edge_detection,
+                                                  kFusedOverlap, "fused_overlap"),
+    AddFuncTaskWithOptions<SobelEdgeDetectionMPI>(kTestParam, PPC_SETTINGS_rychkova_d_sobel_edge_detection, kRowStrips,
+                                                  "strips"),
+    AddFuncTaskWithOptions<SobelEdgeDetectionMPI>(kTestParam, PPC_SETTINGS_rychkova_d_sobel_edge_detection, kBlocks,
+                                                  "blocks"),
+    AddFuncTaskWithOptions<SobelEdgeDetectionMPI>(kTestParam, PPC_SETTINGS_rychkova_d_sobel_edge_detection, kShared,
+                                                  "shared"),
+    AddFuncTaskWithOptions<SobelEdgeDetectionMPI>(kTestParam, PPC_SETTINGS_rychkova_d_sobel_edge_detection,
+                                                  kFusedShared, "fused_shared"),
+    AddFuncTaskWithOptions<SobelEdgeDetectionALL>(kTestParam, PPC_SETTINGS_rychkova_d_sobel_edge_detection, kTiled,
+                                                  "tiled"),
+    AddFuncTaskWithOptions<SobelEdgeDetectionMPI>(kTestParam, PPC_SETTINGS_rychkova_d_sobel_edge_detection, kTiled,
+                                                  "tiled"),
+    AddFuncTaskWithOptions<SobelEdgeDetectionOMP>(kTestParam, PPC_SETTINGS_rychkova_d_sobel_edge_detection, kTiled,
+                                                  "tiled"),
+    AddFuncTaskWithOptions<SobelEdgeDetectionSEQ>(kTestParam, PPC_SETTINGS_rychkova_d_sobel_edge_detection, kTiled,
+                                                  "tiled"),
+    AddFuncTaskWithOptions<SobelEdgeDetectionSTL>(kTestParam, PPC_SETTINGS_rychkova_d_sobel_edge_detection, kTiled,
+                                                  "tiled"),
+    AddFuncTaskWithOptions<SobelEdgeDetectionTBB>(kTestParam, PPC_SETTINGS_rychkova_d_sobel_edge_detection, kTiled,
+                                                  "tiled"));
 
 const auto kGtestValues = ppc::util::ExpandToValues(kTestTasksList);
 
@@ -194,6 +295,914 @@ const auto kTestName = RychkovaDRunFuncTestsSobel::PrintFuncTestName<RychkovaDRu
 
 INSTANTIATE_TEST_SUITE_P(SobelEdgeDetectionTests, RychkovaDRunFuncTestsSobel, kGtestValues, kTestName);
 
+TEST(RychkovaDSobelKernel, SimdRowsMatchScalar) {
+  const std::array<SobelSimdLevel, 4> levels = {SobelSimdLevel::kScalar, SobelSimdLevel::kSse2, SobelSimdLevel::kAvx2,
+                                                SobelSimdLevel::kAvx512};
+  const auto supported = DetectSobelSimdLevel();
+
+  for (const std::size_t w : {3U, 17U, 33U, 64U, 131U}) {
+    std::vector<std::uint8_t> rows(3 * w);
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+      // Mix a pseudo-random pattern with saturated black/white stripes to hit the 255 clamp.
+      const std::size_t value = (i % 7 < 2) ? ((i / 3) % 2) * 255 : (i * 37 + 13) % 256;
+      rows[i] = static_cast<std::uint8_t>(value);
+    }
+    const std::uint8_t *above = rows.data();
+    const std::uint8_t *row = rows.data() + w;
+    const std::uint8_t *below = rows.data() + (2 * w);
+
+    std::vector<std::uint8_t> expected(w, 0);
+    SobelRowScalar(above, row, below, expected.data(), 1, w - 1);
+
+    for (const auto level : levels) {
+      if (level > supported) {
+        continue;
+      }
+      std::vector<std::uint8_t> actual(w, 0);
+      SobelRow(level, above, row, below, actual.data(), 1, w - 1);
+      EXPECT_EQ(actual, expected) << "width " << w << ", level " << static_cast<int>(level);
+    }
+  }
+}
+
+TEST(RychkovaDSobelDistributedOutput, StripsMatchReferenceAndGatherOnRequest) {
+  if (!ppc::util::IsUnderMpirun()) {
+    GTEST_SKIP();
+  }
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  const std::array<SobelOptions, 3> modes = {
+      SobelOptions{.output = SobelOutputMode::kDistributed},
+      SobelOptions{.comm = SobelCommMode::kOverlapped, .output = SobelOutputMode::kDistributed},
+      SobelOptions{.transport = SobelTransport::kSharedWindow, .output = SobelOutputMode::kDistributed}};
+
+  for (const auto &options : modes) {
+    for (const auto &param : kTestParam) {
+      const Image &input = std::get<0>(param);
+      SobelEdgeDetectionSEQ reference(input);
+      ASSERT_TRUE(reference.Validation() && reference.PreProcessing() && reference.Run() && reference.PostProcessing());
+      const Image &expected = reference.GetOutput();
+
+      SobelEdgeDetectionMPI task(input, options);
+      ASSERT_TRUE(task.Validation() && task.PreProcessing() && task.Run() && task.PostProcessing());
+
+      // Every rank holds only its own rows, positioned by the strip descriptor.
+      const OutputStrip &strip = task.GetOutputStrip();
+      const Image &local = task.GetOutput();
+      ASSERT_EQ(strip.width, input.width);
+      ASSERT_EQ(strip.height, input.height);
+      ASSERT_EQ(local.height, strip.rows);
+      ASSERT_LE(strip.row_start + strip.rows, input.height);
+      EXPECT_TRUE(std::equal(local.data.begin(), local.data.end(),
+                             expected.data.begin() + static_cast<std::ptrdiff_t>(strip.row_start * input.width)))
+          << std::get<1>(param);
+
+      ASSERT_TRUE(task.GatherOutput());
+      task.ReleaseTransfers();
+      if (rank == 0) {
+        EXPECT_EQ(task.GetOutput().data, expected.data) << std::get<1>(param);
+        EXPECT_EQ(task.GetOutput().height, input.height);
+      }
+    }
+  }
+}
+
+TEST(RychkovaDSobelStream, FramesMatchSequentialTask) {
+  // Every test image twice, so frames of different sizes and channel counts are in flight together.
+  FrameStream frames;
+  for (int pass = 0; pass < 2; ++pass) {
+    for (const auto &param : kTestParam) {
+      frames.push_back(std::get<0>(param));
+    }
+  }
+
+  const std::array<SobelOptions, 5> modes = {
+      SobelOptions{}, kSeparable, kFusedSeparable, kTiled,
+      // One frame in flight: the stages still run in order, without overlap.
+      SobelOptions{.stream_depth = 1}};
+
+  for (const auto &options : modes) {
+    SobelStreamTBB task(frames, options);
+    ASSERT_TRUE(task.Validation() && task.PreProcessing() && task.Run() && task.PostProcessing());
+    const FrameStream &out = task.GetOutput();
+    ASSERT_EQ(out.size(), frames.size());
+
+    for (std::size_t i = 0; i < frames.size(); ++i) {
+      SobelEdgeDetectionSEQ reference(frames[i], options);
+      ASSERT_TRUE(reference.Validation() && reference.PreProcessing() && reference.Run() && reference.PostProcessing());
+      EXPECT_EQ(out[i].width, frames[i].width);
+      EXPECT_EQ(out[i].height, frames[i].height);
+      EXPECT_EQ(out[i].channels, 1U);
+      EXPECT_EQ(out[i].data, reference.GetOutput().data) << "frame " << i;
+    }
+  }
+}
+
+TEST(RychkovaDSobelBatch, ImagesMatchSequentialTask) {
+  // Every test image three times, packed with a gap so offsets do not simply follow the image sizes.
+  ImageBatch batch;
+  std::vector<Image> images;
+  for (int pass = 0; pass < 3; ++pass) {
+    for (const auto &param : kTestParam) {
+      const Image &img = std::get<0>(param);
+      batch.data.push_back(0xAB);
+      batch.entries.push_back(
+          BatchEntry{.offset = batch.data.size(), .width = img.width, .height = img.height, .channels = img.channels});
+      batch.data.insert(batch.data.end(), img.data.begin(), img.data.end());
+      images.push_back(img);
+    }
+  }
+
+  const std::array<SobelOptions, 4> modes = {SobelOptions{}, kSeparable, kFusedSeparable, kTiled};
+  for (const auto &options : modes) {
+    SobelBatchOMP task(batch, options);
+    ASSERT_TRUE(task.Validation() && task.PreProcessing() && task.Run() && task.PostProcessing());
+    const ImageBatch &out = task.GetOutput();
+    ASSERT_EQ(out.entries.size(), images.size());
+
+    for (std::size_t i = 0; i < images.size(); ++i) {
+      SobelEdgeDetectionSEQ reference(images[i], options);
+      ASSERT_TRUE(reference.Validation() && reference.PreProcessing() && reference.Run() && reference.PostProcessing());
+      const BatchEntry &entry = out.entries[i];
+      EXPECT_EQ(entry.width, images[i].width);
+      EXPECT_EQ(entry.height, images[i].height);
+      EXPECT_EQ(entry.channels, 1U);
+      const auto first = out.data.begin() + static_cast<std::ptrdiff_t>(entry.offset);
+      const PixelBuffer<uint8_t> pixels(first, first + static_cast<std::ptrdiff_t>(entry.width * entry.height));
+      EXPECT_EQ(pixels, reference.GetOutput().data) << "image " << i;
+    }
+  }
+}
+
+// Writes @p img as a binary PGM or PPM with a comment line, or as headerless pixels for kRaw.
+ImageFile WriteImageFile(const Image &img, const std::filesystem::path &path, ImageFileFormat format) {
+  std::ofstream out(path, std::ios::binary);
+  if (format == ImageFileFormat::kPnm) {
+    out << (img.channels == 1 ? "P5" : "P6") << "\n# rychkova_d test image\n" << img.width << ' ' << img.height
+        << "\n255\n";
+  }
+  out.write(reinterpret_cast<const char *>(img.data.data()), static_cast<std::streamsize>(img.data.size()));
+  return ImageFile{
+      .path = path.string(), .format = format, .width = img.width, .height = img.height, .channels = img.channels};
+}
+
+// Last width * height bytes of the output file, i.e. the pixels after any header.
+PixelBuffer<uint8_t> ReadOutputPixels(const ImageFile &file) {
+  std::ifstream in(file.path, std::ios::binary);
+  std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  const std::size_t pixels = file.width * file.height;
+  if (bytes.size() < pixels) {
+    return {};
+  }
+  return {bytes.end() - static_cast<std::ptrdiff_t>(pixels), bytes.end()};
+}
+
+TEST(RychkovaDSobelFile, StripsMatchSequentialTask) {
+  const auto test_env = ppc::util::test::MakePerTestEnvForCurrentGTest("sobel_file");
+  const std::filesystem::path dir = env::get<std::string>("PPC_TEST_TMPDIR").value();
+
+  // One-row strips, strips that do not divide the height, and the default strip taller than every test image.
+  const std::array<SobelOptions, 6> modes = {SobelOptions{.strip_rows = 1},
+                                             SobelOptions{.strip_rows = 4},
+                                             SobelOptions{},
+                                             SobelOptions{.kernel = SobelKernelMode::kSeparable, .strip_rows = 3},
+                                             SobelOptions{.gray = SobelGrayMode::kFused, .strip_rows = 5},
+                                             SobelOptions{.traversal = SobelTraversal::kTiles, .tile_width = 7,
+                                                          .tile_height = 2, .strip_rows = 5}};
+  const std::array<ImageFileFormat, 2> formats = {ImageFileFormat::kPnm, ImageFileFormat::kRaw};
+
+  for (const auto &param : kTestParam) {
+    const Image &img = std::get<0>(param);
+    SobelEdgeDetectionSEQ reference(img);
+    ASSERT_TRUE(reference.Validation() && reference.PreProcessing() && reference.Run() && reference.PostProcessing());
+
+    for (const auto format : formats) {
+      ImageFileJob job{.input = WriteImageFile(img, dir / "in.img", format), .output_path = (dir / "out.img").string()};
+      if (format == ImageFileFormat::kPnm) {
+        // The geometry comes from the header.
+        job.input.width = 0;
+        job.input.height = 0;
+      }
+      for (const auto &options : modes) {
+        SobelFileSEQ task(job, options);
+        ASSERT_TRUE(task.Validation() && task.PreProcessing() && task.Run() && task.PostProcessing());
+        const ImageFile &out = task.GetOutput();
+        EXPECT_EQ(out.width, img.width);
+        EXPECT_EQ(out.height, img.height);
+        EXPECT_EQ(out.channels, 1U);
+        EXPECT_EQ(ReadOutputPixels(out), reference.GetOutput().data) << std::get<1>(param);
+      }
+    }
+  }
+}
+
+// Independent double precision reference of the typed tasks: integer pixels floor the gray value and the magnitude
+// and clamp it to the pixel range, float pixels keep both unrounded.
+template <typename Pixel>
+BasicImage<Pixel> ReferenceSobelOf(const BasicImage<Pixel> &img) {
+  constexpr bool kIntegral = std::is_integral_v<Pixel>;
+  const std::size_t w = img.width;
+  const std::size_t h = img.height;
+  std::vector<double> gray(w * h);
+  for (std::size_t i = 0; i < gray.size(); ++i) {
+    if (img.channels == 1) {
+      gray[i] = static_cast<double>(img.data[i]);
+    } else {
+      const double y = ((77.0 * img.data[(i * 3) + 0]) + (150.0 * img.data[(i * 3) + 1]) +
+                        (29.0 * img.data[(i * 3) + 2])) /
+                       256.0;
+      gray[i] = kIntegral ? std::floor(y) : y;
+    }
+  }
+
+  BasicImage<Pixel> out{.data = PixelBuffer<Pixel>(w * h, Pixel{}), .width = w, .height = h, .channels = 1};
+  for (std::size_t y = 1; y + 1 < h; ++y) {
+    for (std::size_t x = 1; x + 1 < w; ++x) {
+      auto at = [&](std::size_t dx, std::size_t dy) { return gray[((y + dy - 1) * w) + (x + dx - 1)]; };
+      const double gx = (at(2, 0) + (2 * at(2, 1)) + at(2, 2)) - (at(0, 0) + (2 * at(0, 1)) + at(0, 2));
+      const double gy = (at(0, 2) + (2 * at(1, 2)) + at(2, 2)) - (at(0, 0) + (2 * at(1, 0)) + at(2, 0));
+      const double mag = (std::abs(gx) + std::abs(gy)) / 4.0;
+      if constexpr (kIntegral) {
+        out.data[(y * w) + x] = static_cast<Pixel>(std::min(std::floor(mag), 65535.0));
+      } else {
+        out.data[(y * w) + x] = static_cast<Pixel>(mag);
+      }
+    }
+  }
+  return out;
+}
+
+// Test images of several widths (SIMD bodies and tails) with values from @p sample(x, y, c).
+template <typename Pixel, typename Sample>
+std::vector<BasicImage<Pixel>> TypedTestImages(Sample sample) {
+  const std::array<std::array<std::size_t, 3>, 6> shapes = {
+      {{2, 7, 1}, {3, 3, 1}, {37, 5, 1}, {64, 4, 1}, {40, 9, 3}, {19, 11, 3}}};
+  std::vector<BasicImage<Pixel>> images;
+  for (const auto &[w, h, ch] : shapes) {
+    BasicImage<Pixel> img{.data = PixelBuffer<Pixel>(w * h * ch), .width = w, .height = h, .channels = ch};
+    for (std::size_t i = 0; i < img.data.size(); ++i) {
+      img.data[i] = sample((i / ch) % w, (i / ch) / w, i % ch);
+    }
+    images.push_back(std::move(img));
+  }
+  return images;
+}
+
+template <typename Pixel>
+void ExpectTypedTaskMatchesReference(const std::vector<BasicImage<Pixel>> &images) {
+  // The kernel and gray options are accepted for every pixel type; tiles run their own traversal.
+  const std::array<SobelOptions, 4> modes = {
+      SobelOptions{}, kSeparable, kFused,
+      SobelOptions{.traversal = SobelTraversal::kTiles, .tile_width = 9, .tile_height = 2}};
+  for (const auto &img : images) {
+    const BasicImage<Pixel> expected = ReferenceSobelOf(img);
+    for (const auto &options : modes) {
+      BasicSobelEdgeDetectionSEQ<Pixel> task(img, options);
+      ASSERT_TRUE(task.Validation() && task.PreProcessing() && task.Run() && task.PostProcessing());
+      const BasicImage<Pixel> &out = task.GetOutput();
+      EXPECT_EQ(out.width, img.width);
+      EXPECT_EQ(out.height, img.height);
+      EXPECT_EQ(out.channels, 1U);
+      EXPECT_EQ(out.data, expected.data) << img.width << "x" << img.height << "_ch" << img.channels;
+    }
+  }
+}
+
+TEST(RychkovaDSobelPixelTypes, U16MatchesReference) {
+  // 12-bit sensor values, plus saturated columns whose magnitude exceeds the u16 range before the clamp.
+  ExpectTypedTaskMatchesReference(TypedTestImages<uint16_t>([](std::size_t x, std::size_t y, std::size_t c) {
+    return static_cast<uint16_t>(x % 5 == 3 ? 65535 : ((x * 977) + (y * 131) + (c * 17)) % 4096);
+  }));
+}
+
+TEST(RychkovaDSobelPixelTypes, F32MatchesReference) {
+  // Signed integer-valued samples keep every intermediate exact in float, so results compare bit for bit.
+  ExpectTypedTaskMatchesReference(TypedTestImages<float>([](std::size_t x, std::size_t y, std::size_t c) {
+    return static_cast<float>(static_cast<int>(((x * 7) + (y * 13) + (c * 3)) % 200) - 60);
+  }));
+}
+
+// An interleaved RGB image rearranged into @p layout; alpha bytes get a pattern the conversion must ignore.
+Image ToLayout(const Image &rgb, PixelLayout layout) {
+  const std::size_t pixels = rgb.width * rgb.height;
+  const std::size_t channels = layout == PixelLayout::kPlanar ? 3 : 4;
+  Image out{.data = PixelBuffer<uint8_t>(pixels * channels),
+            .width = rgb.width,
+            .height = rgb.height,
+            .channels = channels,
+            .layout = layout};
+  for (std::size_t i = 0; i < pixels; ++i) {
+    const uint8_t r = rgb.data[(i * 3) + 0];
+    const uint8_t g = rgb.data[(i * 3) + 1];
+    const uint8_t b = rgb.data[(i * 3) + 2];
+    const auto a = static_cast<uint8_t>(i * 91);
+    if (layout == PixelLayout::kPlanar) {
+      out.data[i] = r;
+      out.data[pixels + i] = g;
+      out.data[(2 * pixels) + i] = b;
+    } else {
+      const bool rgba = layout == PixelLayout::kRgba;
+      out.data[(i * 4) + 0] = rgba ? r : b;
+      out.data[(i * 4) + 1] = g;
+      out.data[(i * 4) + 2] = rgba ? b : r;
+      out.data[(i * 4) + 3] = a;
+    }
+  }
+  return out;
+}
+
+template <typename TaskType>
+PixelBuffer<uint8_t> RunSobel(const Image &img, const SobelOptions &options = {}) {
+  TaskType task(img, options);
+  if (!(task.Validation() && task.PreProcessing() && task.Run() && task.PostProcessing())) {
+    return {};
+  }
+  return task.GetOutput().data;
+}
+
+constexpr std::array<PixelLayout, 3> kColourLayouts = {PixelLayout::kPlanar, PixelLayout::kRgba, PixelLayout::kBgra};
+
+TEST(RychkovaDSobelLayouts, ConversionKernelsMatchScalarGray) {
+  // 203 pixels: several full SIMD blocks and a tail; the ranges also start and end off block boundaries.
+  Image rgb{.data = PixelBuffer<uint8_t>(203 * 3), .width = 203, .height = 1, .channels = 3};
+  for (std::size_t i = 0; i < rgb.data.size(); ++i) {
+    rgb.data[i] = static_cast<uint8_t>((i % 11 == 0) ? 255 : (i * 73 + 41) % 256);
+  }
+  std::vector<uint8_t> expected(rgb.width);
+  for (std::size_t i = 0; i < rgb.width; ++i) {
+    expected[i] = GrayOf(rgb.data[(i * 3) + 0], rgb.data[(i * 3) + 1], rgb.data[(i * 3) + 2]);
+  }
+
+  const std::array<std::pair<std::size_t, std::size_t>, 2> ranges = {{{0, 203}, {5, 196}}};
+  for (const auto &[begin, end] : ranges) {
+    std::vector<uint8_t> actual(rgb.width, 0);
+    GrayPixels(rgb, actual.data(), begin, end);
+    EXPECT_TRUE(std::equal(actual.begin() + static_cast<std::ptrdiff_t>(begin),
+                           actual.begin() + static_cast<std::ptrdiff_t>(end),
+                           expected.begin() + static_cast<std::ptrdiff_t>(begin)))
+        << "interleaved [" << begin << ", " << end << ")";
+    for (const auto layout : kColourLayouts) {
+      std::vector<uint8_t> converted(rgb.width, 0);
+      GrayPixels(ToLayout(rgb, layout), converted.data(), begin, end);
+      EXPECT_TRUE(std::equal(converted.begin() + static_cast<std::ptrdiff_t>(begin),
+                             converted.begin() + static_cast<std::ptrdiff_t>(end),
+                             expected.begin() + static_cast<std::ptrdiff_t>(begin)))
+          << "layout " << static_cast<int>(layout) << " [" << begin << ", " << end << ")";
+    }
+  }
+}
+
+TEST(RychkovaDSobelLayouts, TasksMatchInterleavedInput) {
+  for (const auto &param : kTestParam) {
+    const Image &rgb = std::get<0>(param);
+    if (rgb.channels != 3) {
+      continue;
+    }
+    const PixelBuffer<uint8_t> expected = RunSobel<SobelEdgeDetectionSEQ>(rgb);
+    for (const auto layout : kColourLayouts) {
+      const Image img = ToLayout(rgb, layout);
+      EXPECT_EQ(RunSobel<SobelEdgeDetectionSEQ>(img), expected) << std::get<1>(param);
+      EXPECT_EQ(RunSobel<SobelEdgeDetectionSEQ>(img, kFusedSeparable), expected) << std::get<1>(param);
+      EXPECT_EQ(RunSobel<SobelEdgeDetectionSEQ>(img, kTiled), expected) << std::get<1>(param);
+      EXPECT_EQ(RunSobel<SobelEdgeDetectionOMP>(img), expected) << std::get<1>(param);
+      EXPECT_EQ(RunSobel<SobelEdgeDetectionSTL>(img), expected) << std::get<1>(param);
+      EXPECT_EQ(RunSobel<SobelEdgeDetectionTBB>(img), expected) << std::get<1>(param);
+
+      SobelStreamTBB stream(FrameStream{img, rgb}, kFused);
+      ASSERT_TRUE(stream.Validation() && stream.PreProcessing() && stream.Run() && stream.PostProcessing());
+      EXPECT_EQ(stream.GetOutput()[0].data, expected) << std::get<1>(param);
+      EXPECT_EQ(stream.GetOutput()[1].data, expected) << std::get<1>(param);
+    }
+  }
+}
+
+TEST(RychkovaDSobelLayouts, MpiTasksMatchInterleavedInput) {
+  if (!ppc::util::IsUnderMpirun()) {
+    GTEST_SKIP();
+  }
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  for (const auto &param : kTestParam) {
+    const Image &rgb = std::get<0>(param);
+    if (rgb.channels != 3) {
+      continue;
+    }
+    const PixelBuffer<uint8_t> expected = RunSobel<SobelEdgeDetectionSEQ>(rgb);
+    for (const auto layout : kColourLayouts) {
+      const Image img = ToLayout(rgb, layout);
+      const PixelBuffer<uint8_t> mpi = RunSobel<SobelEdgeDetectionMPI>(img);
+      const PixelBuffer<uint8_t> mpi_fused = RunSobel<SobelEdgeDetectionMPI>(img, kFusedOverlap);
+      const PixelBuffer<uint8_t> all = RunSobel<SobelEdgeDetectionALL>(img);
+      if (rank == 0) {
+        EXPECT_EQ(mpi, expected) << std::get<1>(param);
+        EXPECT_EQ(mpi_fused, expected) << std::get<1>(param);
+        EXPECT_EQ(all, expected) << std::get<1>(param);
+      }
+    }
+  }
+}
+
+// @p img copied to (x, y) of a padded canvas filled with noise, and handed back as the Roi of the canvas it fills.
+template <typename Pixel>
+BasicImage<Pixel> EmbedInCanvas(const BasicImage<Pixel> &img, std::size_t x, std::size_t y) {
+  auto canvas = MakePaddedImage<Pixel>(img.width + x + 5, img.height + y + 4, img.channels, img.layout);
+  for (std::size_t i = 0; i < canvas.data.size(); ++i) {
+    canvas.data[i] = static_cast<Pixel>((i * 151 + 7) % 251);
+  }
+  const std::size_t row = img.width * img.channels;
+  for (std::size_t r = 0; r < img.height; ++r) {
+    std::copy(img.Row(r), img.Row(r) + row, canvas.Row(y + r) + (x * img.channels));
+  }
+  return Roi(std::move(canvas), x, y, img.width, img.height);
+}
+
+TEST(RychkovaDSobelStride, PaddedRowsStartOnCacheLines) {
+  const Image rgb = MakePaddedImage<uint8_t>(100, 5, 3);
+  EXPECT_EQ(rgb.stride % kImageAlignment, 0U);
+  EXPECT_GE(rgb.stride, 300U);
+  for (std::size_t y = 0; y < rgb.height; ++y) {
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(rgb.Row(y)) % kImageAlignment, 0U) << "row " << y;
+  }
+  const ImageF32 f32 = MakePaddedImage<float>(17, 3);
+  EXPECT_EQ((f32.stride * sizeof(float)) % kImageAlignment, 0U);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(f32.Row(2)) % kImageAlignment, 0U);
+  EXPECT_TRUE(ValidImageBuffer(rgb));
+  EXPECT_TRUE(ValidImageBuffer(f32));
+}
+
+TEST(RychkovaDSobelStride, BufferChecksCoverEveryRow) {
+  Image img = MakePaddedImage<uint8_t>(10, 4);
+  EXPECT_TRUE(ValidImageBuffer(img));
+  img.stride = 9;
+  EXPECT_FALSE(ValidImageBuffer(img));
+
+  img = Roi(MakePaddedImage<uint8_t>(10, 4), 2, 1, 8, 3);
+  EXPECT_TRUE(ValidImageBuffer(img));
+  EXPECT_FALSE(img.Packed());
+  img.height = 4;
+  EXPECT_FALSE(ValidImageBuffer(img));
+
+  const Image planar{.data = PixelBuffer<uint8_t>(64 * 2 * 3),
+                     .width = 2,
+                     .height = 2,
+                     .channels = 3,
+                     .layout = PixelLayout::kPlanar,
+                     .stride = 64};
+  EXPECT_FALSE(ValidImageBuffer(planar));
+}
+
+TEST(RychkovaDSobelStride, RoisMatchPackedInput) {
+  for (const auto &param : kTestParam) {
+    const Image &img = std::get<0>(param);
+    const PixelBuffer<uint8_t> expected = RunSobel<SobelEdgeDetectionSEQ>(img);
+    std::vector<Image> inputs = {EmbedInCanvas(img, 3, 2)};
+    if (img.channels == 3) {
+      inputs.push_back(EmbedInCanvas(ToLayout(img, PixelLayout::kBgra), 1, 1));
+    }
+    for (const auto &roi : inputs) {
+      EXPECT_EQ(RunSobel<SobelEdgeDetectionSEQ>(roi), expected) << std::get<1>(param);
+      EXPECT_EQ(RunSobel<SobelEdgeDetectionSEQ>(roi, kFused), expected) << std::get<1>(param);
+      EXPECT_EQ(RunSobel<SobelEdgeDetectionSEQ>(roi, kFusedSeparable), expected) << std::get<1>(param);
+      EXPECT_EQ(RunSobel<SobelEdgeDetectionSEQ>(roi, kTiled), expected) << std::get<1>(param);
+      EXPECT_EQ(RunSobel<SobelEdgeDetectionOMP>(roi), expected) << std::get<1>(param);
+      EXPECT_EQ(RunSobel<SobelEdgeDetectionSTL>(roi), expected) << std::get<1>(param);
+      EXPECT_EQ(RunSobel<SobelEdgeDetectionTBB>(roi), expected) << std::get<1>(param);
+
+      SobelStreamTBB stream(FrameStream{roi}, kFused);
+      ASSERT_TRUE(stream.Validation() && stream.PreProcessing() && stream.Run() && stream.PostProcessing());
+      EXPECT_EQ(stream.GetOutput()[0].data, expected) << std::get<1>(param);
+    }
+  }
+}
+
+TEST(RychkovaDSobelStride, TypedRoisMatchPackedInput) {
+  const auto images = TypedTestImages<uint16_t>([](std::size_t x, std::size_t y, std::size_t c) {
+    return static_cast<uint16_t>(((x * 977) + (y * 131) + c) % 4096);
+  });
+  for (const auto &img : images) {
+    BasicSobelEdgeDetectionSEQ<uint16_t> packed(img);
+    BasicSobelEdgeDetectionSEQ<uint16_t> roi(EmbedInCanvas(img, 2, 3));
+    ASSERT_TRUE(packed.Validation() && packed.PreProcessing() && packed.Run() && packed.PostProcessing());
+    ASSERT_TRUE(roi.Validation() && roi.PreProcessing() && roi.Run() && roi.PostProcessing());
+    EXPECT_EQ(roi.GetOutput().data, packed.GetOutput().data) << img.width << "x" << img.height << "_ch" << img.channels;
+  }
+}
+
+TEST(RychkovaDSobelStride, MpiRoisMatchPackedInput) {
+  if (!ppc::util::IsUnderMpirun()) {
+    GTEST_SKIP();
+  }
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  for (const auto &param : kTestParam) {
+    const Image &img = std::get<0>(param);
+    const PixelBuffer<uint8_t> expected = RunSobel<SobelEdgeDetectionSEQ>(img);
+    const Image roi = EmbedInCanvas(img, 3, 2);
+    const PixelBuffer<uint8_t> mpi = RunSobel<SobelEdgeDetectionMPI>(roi);
+    const PixelBuffer<uint8_t> mpi_blocks = RunSobel<SobelEdgeDetectionMPI>(roi, kBlocks);
+    const PixelBuffer<uint8_t> all = RunSobel<SobelEdgeDetectionALL>(roi);
+    if (rank == 0) {
+      EXPECT_EQ(mpi, expected) << std::get<1>(param);
+      EXPECT_EQ(mpi_blocks, expected) << std::get<1>(param);
+      EXPECT_EQ(all, expected) << std::get<1>(param);
+    }
+  }
+}
+
+/// @brief Runs the whole pipeline of @p task again on @p img, the way the performance runs repeat it.
+/// @details Validation is skipped past: it rejects the output the previous run left behind.
+template <typename TaskType, typename InputType>
+bool RerunSobel(TaskType &task, const InputType &img) {
+  task.GetInput() = img;
+  task.Validation();
+  return task.PreProcessing() && task.Run() && task.PostProcessing();
+}
+
+/// @brief Test images from the largest to the smallest and back, so a reused workspace both shrinks and grows.
+std::vector<Image> ShrinkingAndGrowingImages() {
+  std::vector<Image> images;
+  for (auto it = kTestParam.rbegin(); it != kTestParam.rend(); ++it) {
+    images.push_back(std::get<0>(*it));
+  }
+  for (const auto &param : kTestParam) {
+    images.push_back(std::get<0>(param));
+  }
+  return images;
+}
+
+template <typename TaskType>
+void ExpectReusedTaskMatchesFreshRuns(const SobelOptions &options) {
+  const std::vector<Image> images = ShrinkingAndGrowingImages();
+  TaskType task(images.front(), options);
+  ASSERT_TRUE(task.Validation() && task.PreProcessing() && task.Run() && task.PostProcessing());
+  for (std::size_t i = 0; i < images.size(); ++i) {
+    if (i != 0) {
+      ASSERT_TRUE(RerunSobel(task, images[i]));
+    }
+    EXPECT_EQ(task.GetOutput().data, RunSobel<SobelEdgeDetectionSEQ>(images[i], options))
+        << images[i].width << "x" << images[i].height << "_ch" << images[i].channels;
+  }
+}
+
+TEST(RychkovaDSobelWorkspace, RepeatedRunsReuseTheOutputBuffer) {
+  const Image &img = std::get<0>(kTestParam.back());
+  SobelEdgeDetectionSEQ task(img);
+  ASSERT_TRUE(task.Validation() && task.PreProcessing() && task.Run() && task.PostProcessing());
+  const PixelBuffer<uint8_t> first = task.GetOutput().data;
+  const uint8_t *buffer = task.GetOutput().data.data();
+
+  ASSERT_TRUE(RerunSobel(task, img));
+  EXPECT_EQ(task.GetOutput().data.data(), buffer);
+  EXPECT_EQ(task.GetOutput().data, first);
+}
+
+TEST(RychkovaDSobelWorkspace, ReusedTasksMatchFreshRuns) {
+  for (const auto &options : {SobelOptions{}, kSeparable, kFused, kTiled}) {
+    ExpectReusedTaskMatchesFreshRuns<SobelEdgeDetectionSEQ>(options);
+    ExpectReusedTaskMatchesFreshRuns<SobelEdgeDetectionOMP>(options);
+    ExpectReusedTaskMatchesFreshRuns<SobelEdgeDetectionSTL>(options);
+    ExpectReusedTaskMatchesFreshRuns<SobelEdgeDetectionTBB>(options);
+  }
+}
+
+TEST(RychkovaDSobelWorkspace, ReusedStreamAndBatchMatchFreshRuns) {
+  const std::vector<Image> images = ShrinkingAndGrowingImages();
+  const FrameStream large(images.begin(), images.begin() + 3);
+  const FrameStream small(images.begin() + 3, images.begin() + 6);
+
+  SobelStreamTBB stream(large);
+  ASSERT_TRUE(stream.Validation() && stream.PreProcessing() && stream.Run() && stream.PostProcessing());
+  ASSERT_TRUE(RerunSobel(stream, small));
+  ASSERT_EQ(stream.GetOutput().size(), small.size());
+  for (std::size_t i = 0; i < small.size(); ++i) {
+    EXPECT_EQ(stream.GetOutput()[i].data, RunSobel<SobelEdgeDetectionSEQ>(small[i])) << "frame " << i;
+  }
+
+  // The second batch packs the same images in reverse order, so every image lands on pixels of another one.
+  auto pack = [](const FrameStream &frames) {
+    ImageBatch batch;
+    for (const auto &img : frames) {
+      batch.entries.push_back(
+          BatchEntry{.offset = batch.data.size(), .width = img.width, .height = img.height, .channels = img.channels});
+      batch.data.insert(batch.data.end(), img.data.begin(), img.data.end());
+    }
+    return batch;
+  };
+  const FrameStream reversed(small.rbegin(), small.rend());
+  SobelBatchOMP batch(pack(small));
+  ASSERT_TRUE(batch.Validation() && batch.PreProcessing() && batch.Run() && batch.PostProcessing());
+  ASSERT_TRUE(RerunSobel(batch, pack(reversed)));
+  const ImageBatch &out = batch.GetOutput();
+  ASSERT_EQ(out.entries.size(), reversed.size());
+  for (std::size_t i = 0; i < reversed.size(); ++i) {
+    const auto first = out.data.begin() + static_cast<std::ptrdiff_t>(out.entries[i].offset);
+    const auto pixel_count = static_cast<std::ptrdiff_t>(reversed[i].width * reversed[i].height);
+    const PixelBuffer<uint8_t> pixels(first, first + pixel_count);
+    EXPECT_EQ(pixels, RunSobel<SobelEdgeDetectionSEQ>(reversed[i])) << "image " << i;
+  }
+}
+
+TEST(RychkovaDSobelWorkspace, ReusedMpiTasksMatchFreshRuns) {
+  if (!ppc::util::IsUnderMpirun()) {
+    GTEST_SKIP();
+  }
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  const std::vector<Image> images = ShrinkingAndGrowingImages();
+  for (const auto &options : {SobelOptions{}, kFusedOverlap, kBlocks}) {
+    SobelEdgeDetectionMPI mpi(images.front(), options);
+    SobelEdgeDetectionALL all(images.front(), options);
+    ASSERT_TRUE(mpi.Validation() && mpi.PreProcessing() && mpi.Run() && mpi.PostProcessing());
+    ASSERT_TRUE(all.Validation() && all.PreProcessing() && all.Run() && all.PostProcessing());
+    for (std::size_t i = 1; i < images.size(); ++i) {
+      ASSERT_TRUE(RerunSobel(mpi, images[i]));
+      ASSERT_TRUE(RerunSobel(all, images[i]));
+      if (rank == 0) {
+        const PixelBuffer<uint8_t> expected = RunSobel<SobelEdgeDetectionSEQ>(images[i], options);
+        EXPECT_EQ(mpi.GetOutput().data, expected) << images[i].width << "x" << images[i].height;
+        EXPECT_EQ(all.GetOutput().data, expected) << images[i].width << "x" << images[i].height;
+      }
+    }
+  }
+}
+
+TEST(RychkovaDSobelWorkspace, RepeatedMpiRunsReplayTheirPlan) {
+  if (!ppc::util::IsUnderMpirun()) {
+    GTEST_SKIP();
+  }
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  // Runs over one geometry keep the plan of the first, so every transfer path is replayed unchanged.
+  const Image &img = std::get<0>(kTestParam.back());
+  const PixelBuffer<uint8_t> expected = RunSobel<SobelEdgeDetectionSEQ>(img);
+  for (const auto &options : {SobelOptions{}, kExchange, kFusedOverlap, kBlocks, kShared}) {
+    SobelEdgeDetectionMPI mpi(img, options);
+    SobelEdgeDetectionALL all(img, options);
+    ASSERT_TRUE(mpi.Validation() && mpi.PreProcessing() && mpi.Run() && mpi.PostProcessing());
+    ASSERT_TRUE(all.Validation() && all.PreProcessing() && all.Run() && all.PostProcessing());
+    for (int run = 0; run < 3; ++run) {
+      ASSERT_TRUE(RerunSobel(mpi, img));
+      ASSERT_TRUE(RerunSobel(all, img));
+      if (rank == 0) {
+        EXPECT_EQ(mpi.GetOutput().data, expected) << "run " << run;
+        EXPECT_EQ(all.GetOutput().data, expected) << "run " << run;
+      }
+    }
+    mpi.ReleaseTransfers();
+  }
+}
+
+// Taps and norm of each stencil, written out here rather than taken from sobel_stencil.hpp.
+struct StencilCase {
+  SobelStencil stencil = SobelStencil::kSobel;
+  std::vector<int> smooth;
+  std::vector<int> derive;
+  double norm = 1.0;
+  std::string name;
+};
+
+const std::array<StencilCase, 4> kStencilCases = {{
+    {.stencil = SobelStencil::kSobel, .smooth = {1, 2, 1}, .derive = {-1, 0, 1}, .norm = 4.0, .name = "sobel"},
+    {.stencil = SobelStencil::kScharr, .smooth = {3, 10, 3}, .derive = {-1, 0, 1}, .norm = 16.0, .name = "scharr"},
+    {.stencil = SobelStencil::kPrewitt, .smooth = {1, 1, 1}, .derive = {-1, 0, 1}, .norm = 3.0, .name = "prewitt"},
+    {.stencil = SobelStencil::kSobel5x5,
+     .smooth = {1, 4, 6, 4, 1},
+     .derive = {-1, -2, 0, 2, 1},
+     .norm = 48.0,
+     .name = "sobel5x5"},
+}};
+
+// Double precision reference of any stencil, applying the full 2D kernels smooth^T * derive (gx) and
+// derive^T * smooth (gy) pixel by pixel; gray values and magnitudes round as in ReferenceSobelOf.
+template <typename Pixel>
+BasicImage<Pixel> ReferenceStencilOf(const BasicImage<Pixel> &img, const StencilCase &stencil) {
+  constexpr bool kIntegral = std::is_integral_v<Pixel>;
+  const std::size_t w = img.width;
+  const std::size_t h = img.height;
+  const std::size_t taps = stencil.smooth.size();
+  const std::size_t r = taps / 2;
+  std::vector<double> gray(w * h);
+  for (std::size_t i = 0; i < gray.size(); ++i) {
+    if (img.channels == 1) {
+      gray[i] = static_cast<double>(img.data[i]);
+    } else {
+      const double y = ((77.0 * img.data[(i * 3) + 0]) + (150.0 * img.data[(i * 3) + 1]) +
+                        (29.0 * img.data[(i * 3) + 2])) /
+                       256.0;
+      gray[i] = kIntegral ? std::floor(y) : y;
+    }
+  }
+
+  BasicImage<Pixel> out{.data = PixelBuffer<Pixel>(w * h, Pixel{}), .width = w, .height = h, .channels = 1};
+  for (std::size_t y = r; y + r < h; ++y) {
+    for (std::size_t x = r; x + r < w; ++x) {
+      double gx = 0.0;
+      double gy = 0.0;
+      for (std::size_t i = 0; i < taps; ++i) {
+        for (std::size_t j = 0; j < taps; ++j) {
+          const double p = gray[((y + i - r) * w) + (x + j - r)];
+          gx += stencil.smooth[i] * stencil.derive[j] * p;
+          gy += stencil.derive[i] * stencil.smooth[j] * p;
+        }
+      }
+      const double mag = (std::abs(gx) + std::abs(gy)) / stencil.norm;
+      if constexpr (kIntegral) {
+        const auto max = static_cast<double>(std::numeric_limits<Pixel>::max());
+        out.data[(y * w) + x] = static_cast<Pixel>(std::min(std::floor(mag), max));
+      } else {
+        out.data[(y * w) + x] = static_cast<Pixel>(mag);
+      }
+    }
+  }
+  return out;
+}
+
+// Integer pixels must match exactly; float pixels up to the rounding of the 1 / norm scale.
+template <typename Pixel>
+void ExpectStencilOutput(const PixelBuffer<Pixel> &actual, const BasicImage<Pixel> &expected,
+                         const std::string &what) {
+  ASSERT_EQ(actual.size(), expected.data.size()) << what;
+  if constexpr (std::is_integral_v<Pixel>) {
+    EXPECT_EQ(actual, expected.data) << what;
+  } else {
+    for (std::size_t i = 0; i < actual.size(); ++i) {
+      ASSERT_NEAR(actual[i], expected.data[i], 1e-4F * std::max(1.0F, std::abs(expected.data[i]))) << what << " @" << i;
+    }
+  }
+}
+
+std::string StencilLabel(const StencilCase &stencil, const Image &img) {
+  return stencil.name + " " + std::to_string(img.width) + "x" + std::to_string(img.height) + "_ch" +
+         std::to_string(img.channels);
+}
+
+// The test images plus images no wider or taller than the 5x5 stencil, whose output is all border.
+std::vector<Image> StencilTestImages() {
+  std::vector<Image> images = TypedTestImages<uint8_t>([](std::size_t x, std::size_t y, std::size_t c) {
+    return static_cast<uint8_t>(x % 4 == 1 ? 255 : ((x * 37) + (y * 101) + (c * 59)) % 256);
+  });
+  for (const auto &param : kTestParam) {
+    images.push_back(std::get<0>(param));
+  }
+  return images;
+}
+
+TEST(RychkovaDSobelStencil, StepEdgesKeepTheirHeight) {
+  // A vertical step from 0 to 200: the kernels are normalized, so every stencil reports the step height on the
+  // first column of the step and nothing where its window sees a flat area.
+  const std::size_t w = 12;
+  const std::size_t h = 9;
+  Image img{.data = PixelBuffer<uint8_t>(w * h), .width = w, .height = h, .channels = 1};
+  for (std::size_t i = 0; i < img.data.size(); ++i) {
+    img.data[i] = i % w >= 6 ? 200 : 0;
+  }
+  for (const auto &stencil : kStencilCases) {
+    const PixelBuffer<uint8_t> out = RunSobel<SobelEdgeDetectionSEQ>(img, SobelOptions{.stencil = stencil.stencil});
+    ASSERT_EQ(out.size(), img.data.size()) << stencil.name;
+    EXPECT_EQ(out[(4 * w) + 6], 200) << stencil.name;
+    EXPECT_EQ(out[(4 * w) + 2], 0) << stencil.name;
+    EXPECT_EQ(out[(4 * w) + 9], 0) << stencil.name;
+  }
+}
+
+TEST(RychkovaDSobelStencil, SharedMemoryTasksMatchReference) {
+  for (const auto &stencil : kStencilCases) {
+    // Kernel, gray and traversal options tune the 3x3 Sobel stencil only; the others ignore them.
+    const SobelStencil s = stencil.stencil;
+    const std::array<SobelOptions, 4> modes = {
+        SobelOptions{.stencil = s}, SobelOptions{.stencil = s, .kernel = SobelKernelMode::kSeparable},
+        SobelOptions{.stencil = s, .gray = SobelGrayMode::kFused},
+        SobelOptions{.stencil = s, .traversal = SobelTraversal::kTiles, .tile_width = 7, .tile_height = 3}};
+    for (const auto &img : StencilTestImages()) {
+      const Image expected = ReferenceStencilOf(img, stencil);
+      const std::string label = StencilLabel(stencil, img);
+      for (const auto &options : modes) {
+        ExpectStencilOutput(RunSobel<SobelEdgeDetectionSEQ>(img, options), expected, label + " seq");
+        ExpectStencilOutput(RunSobel<SobelEdgeDetectionOMP>(img, options), expected, label + " omp");
+        ExpectStencilOutput(RunSobel<SobelEdgeDetectionSTL>(img, options), expected, label + " stl");
+        ExpectStencilOutput(RunSobel<SobelEdgeDetectionTBB>(img, options), expected, label + " tbb");
+      }
+    }
+  }
+}
+
+TEST(RychkovaDSobelStencil, StreamAndBatchMatchReference) {
+  const std::vector<Image> images = StencilTestImages();
+  ImageBatch batch;
+  for (const auto &img : images) {
+    batch.entries.push_back(
+        BatchEntry{.offset = batch.data.size(), .width = img.width, .height = img.height, .channels = img.channels});
+    batch.data.insert(batch.data.end(), img.data.begin(), img.data.end());
+  }
+
+  for (const auto &stencil : kStencilCases) {
+    const SobelOptions options{.stencil = stencil.stencil};
+    SobelStreamTBB stream(FrameStream(images.begin(), images.end()), options);
+    ASSERT_TRUE(stream.Validation() && stream.PreProcessing() && stream.Run() && stream.PostProcessing());
+    SobelBatchOMP batch_task(batch, options);
+    ASSERT_TRUE(batch_task.Validation() && batch_task.PreProcessing() && batch_task.Run() &&
+                batch_task.PostProcessing());
+    const ImageBatch &out = batch_task.GetOutput();
+    ASSERT_EQ(stream.GetOutput().size(), images.size());
+    ASSERT_EQ(out.entries.size(), images.size());
+
+    for (std::size_t i = 0; i < images.size(); ++i) {
+      const Image expected = ReferenceStencilOf(images[i], stencil);
+      const std::string label = StencilLabel(stencil, images[i]);
+      ExpectStencilOutput(stream.GetOutput()[i].data, expected, label + " stream");
+      const auto first = out.data.begin() + static_cast<std::ptrdiff_t>(out.entries[i].offset);
+      const auto pixel_count = static_cast<std::ptrdiff_t>(images[i].width * images[i].height);
+      ExpectStencilOutput(PixelBuffer<uint8_t>(first, first + pixel_count), expected, label + " batch");
+    }
+  }
+}
+
+TEST(RychkovaDSobelStencil, FileStripsMatchReference) {
+  const auto test_env = ppc::util::test::MakePerTestEnvForCurrentGTest("sobel_file");
+  const std::filesystem::path dir = env::get<std::string>("PPC_TEST_TMPDIR").value();
+
+  for (const auto &stencil : kStencilCases) {
+    // One-row strips carry a halo twice their height under the 5x5 stencil.
+    const std::array<SobelOptions, 3> modes = {SobelOptions{.stencil = stencil.stencil, .strip_rows = 1},
+                                               SobelOptions{.stencil = stencil.stencil, .strip_rows = 3},
+                                               SobelOptions{.stencil = stencil.stencil}};
+    for (const auto &img : StencilTestImages()) {
+      const Image expected = ReferenceStencilOf(img, stencil);
+      const ImageFileJob job{.input = WriteImageFile(img, dir / "in.img", ImageFileFormat::kRaw),
+                             .output_path = (dir / "out.img").string()};
+      for (const auto &options : modes) {
+        SobelFileSEQ task(job, options);
+        ASSERT_TRUE(task.Validation() && task.PreProcessing() && task.Run() && task.PostProcessing());
+        ExpectStencilOutput(ReadOutputPixels(task.GetOutput()), expected,
+                            StencilLabel(stencil, img) + " strip_rows " + std::to_string(options.strip_rows));
+      }
+    }
+  }
+}
+
+template <typename Pixel>
+void ExpectTypedStencilsMatchReference(const std::vector<BasicImage<Pixel>> &images) {
+  for (const auto &stencil : kStencilCases) {
+    for (const auto &img : images) {
+      BasicSobelEdgeDetectionSEQ<Pixel> task(img, SobelOptions{.stencil = stencil.stencil});
+      ASSERT_TRUE(task.Validation() && task.PreProcessing() && task.Run() && task.PostProcessing());
+      ExpectStencilOutput(task.GetOutput().data, ReferenceStencilOf(img, stencil),
+                          stencil.name + " " + std::to_string(img.width) + "x" + std::to_string(img.height));
+    }
+  }
+}
+
+TEST(RychkovaDSobelStencil, TypedPixelsMatchReference) {
+  // Saturated columns push the 5x5 magnitude far past the u16 range before the clamp.
+  ExpectTypedStencilsMatchReference(TypedTestImages<uint16_t>([](std::size_t x, std::size_t y, std::size_t c) {
+    return static_cast<uint16_t>(x % 5 == 3 ? 65535 : ((x * 977) + (y * 131) + (c * 17)) % 4096);
+  }));
+  ExpectTypedStencilsMatchReference(TypedTestImages<float>([](std::size_t x, std::size_t y, std::size_t c) {
+    return static_cast<float>(static_cast<int>(((x * 7) + (y * 13) + (c * 3)) % 200) - 60);
+  }));
+}
+
+TEST(RychkovaDSobelStencil, MpiTasksMatchReference) {
+  if (!ppc::util::IsUnderMpirun()) {
+    GTEST_SKIP();
+  }
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  for (const auto &stencil : kStencilCases) {
+    const SobelOptions options{.stencil = stencil.stencil};
+    const SobelOptions distributed{.stencil = stencil.stencil, .output = SobelOutputMode::kDistributed};
+    for (const auto &img : StencilTestImages()) {
+      const Image expected = ReferenceStencilOf(img, stencil);
+      const std::string label = StencilLabel(stencil, img);
+      const PixelBuffer<uint8_t> mpi = RunSobel<SobelEdgeDetectionMPI>(img, options);
+      const PixelBuffer<uint8_t> all = RunSobel<SobelEdgeDetectionALL>(img, options);
+
+      // Strips of the wider stencil carry up to two halo rows per side.
+      SobelEdgeDetectionMPI strips(img, distributed);
+      ASSERT_TRUE(strips.Validation() && strips.PreProcessing() && strips.Run() && strips.PostProcessing());
+      const OutputStrip &strip = strips.GetOutputStrip();
+      const PixelBuffer<uint8_t> &local = strips.GetOutput().data;
+      ASSERT_EQ(local.size(), strip.rows * img.width) << label;
+      EXPECT_TRUE(std::equal(local.begin(), local.end(),
+                             expected.data.begin() + static_cast<std::ptrdiff_t>(strip.row_start * img.width)))
+          << label;
+      ASSERT_TRUE(strips.GatherOutput());
+
+      if (rank == 0) {
+        ExpectStencilOutput(mpi, expected, label + " mpi");
+        ExpectStencilOutput(all, expected, label + " all");
+        ExpectStencilOutput(strips.GetOutput().data, expected, label + " distributed");
+      }
+    }
+  }
+}
+
 }  // namespace
 
 }  // namespace rychkova_d_sobel_edge_detection
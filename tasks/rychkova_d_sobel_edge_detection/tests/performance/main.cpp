@@ -1,13 +1,29 @@
 #include <gtest/gtest.h>
+#include <libenvpp/detail/get.hpp>
 #include <mpi.h>
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
 #include <vector>
 
+#include "rychkova_d_sobel_edge_detection/all/include/ops_all.hpp"
 #include "rychkova_d_sobel_edge_detection/common/include/common.hpp"
 #include "rychkova_d_sobel_edge_detection/mpi/include/ops_mpi.hpp"
+#include "rychkova_d_sobel_edge_detection/omp/include/ops_omp.hpp"
+#include "rychkova_d_sobel_edge_detection/omp/include/ops_omp_batch.hpp"
 #include "rychkova_d_sobel_edge_detection/seq/include/ops_seq.hpp"
+#include "rychkova_d_sobel_edge_detection/seq/include/ops_seq_file.hpp"
+#include "rychkova_d_sobel_edge_detection/stl/include/ops_stl.hpp"
+#include "rychkova_d_sobel_edge_detection/tbb/include/ops_tbb.hpp"
+#include "rychkova_d_sobel_edge_detection/tbb/include/ops_tbb_stream.hpp"
 #include "util/include/perf_test_util.hpp"
 
 namespace rychkova_d_sobel_edge_detection {
@@ -43,16 +59,25 @@ class RychkovaDRunPerfTestsSobel : public ppc::util::BaseRunPerfTests<InType, Ou
       return true;
     }
 
+    // Distributed output leaves rank 0 with its own row strip only.
+    std::size_t expected_height = input_data_.height;
+    const auto &test_name = std::get<static_cast<std::size_t>(ppc::util::GTestParamIndex::kNameTest)>(GetParam());
+    if (mpi_inited && test_name.ends_with("_distributed")) {
+      int size = 1;
+      MPI_Comm_size(MPI_COMM_WORLD, &size);
+      expected_height = StripOf(0, static_cast<std::size_t>(size), input_data_.height).rows;
+    }
+
     if (output_data.width != input_data_.width) {
       return false;
     }
-    if (output_data.height != input_data_.height) {
+    if (output_data.height != expected_height) {
       return false;
     }
     if (output_data.channels != 1) {
       return false;
     }
-    if (output_data.data.size() != input_data_.width * input_data_.height) {
+    if (output_data.data.size() != input_data_.width * expected_height) {
       return false;
     }
 
@@ -68,13 +93,354 @@ TEST_P(RychkovaDRunPerfTestsSobel, RunPerfModes) {
   ExecuteTest(GetParam());
 }
 
-const auto kAllPerfTasks = ppc::util::MakeAllPerfTasks<InType, SobelEdgeDetectionMPI, SobelEdgeDetectionSEQ>(
-    PPC_SETTINGS_rychkova_d_sobel_edge_detection);
+/// @brief Same as ppc::util::MakePerfTaskTuples, but constructs the task with @p options and tags it with @p mode_name.
+template <typename TaskType, typename In = InType, typename Out = OutType>
+auto MakePerfTaskTuplesWithOptions(const std::string &settings_path, SobelOptions options,
+                                   const std::string &mode_name) {
+  const auto name = ppc::util::GetNamespace<TaskType>() + "_" +
+                    ppc::task::GetStringTaskType(TaskType::GetStaticTypeOfTask(), settings_path) + "_" + mode_name;
+  const std::function<ppc::task::TaskPtr<In, Out>(In)> getter = [options](In in) -> ppc::task::TaskPtr<In, Out> {
+    return std::make_shared<TaskType>(std::move(in), options);
+  };
+
+  return std::make_tuple(std::make_tuple(getter, name, ppc::performance::PerfResults::TypeOfRunning::kPipeline),
+                         std::make_tuple(getter, name, ppc::performance::PerfResults::TypeOfRunning::kTaskRun));
+}
+
+const SobelOptions kSeparable{.kernel = SobelKernelMode::kSeparable};
+const SobelOptions kFused{.gray = SobelGrayMode::kFused};
+const SobelOptions kTiled{.traversal = SobelTraversal::kTiles};
+const SobelOptions kExchange{.halo = SobelHaloMode::kExchange};
+const SobelOptions kOverlap{.comm = SobelCommMode::kOverlapped};
+const SobelOptions kBlocks{.decomposition = SobelDecomposition::kBlocks};
+const SobelOptions kShared{.transport = SobelTransport::kSharedWindow};
+const SobelOptions kDistributed{.output = SobelOutputMode::kDistributed};
 
-const auto kGtestValues = ppc::util::TupleToGTestValues(kAllPerfTasks);
+const auto kAllPerfTasks =
+    ppc::util::MakeAllPerfTasks<InType, SobelEdgeDetectionALL, SobelEdgeDetectionMPI, SobelEdgeDetectionOMP,
+                                SobelEdgeDetectionSEQ, SobelEdgeDetectionSTL, SobelEdgeDetectionTBB>(
+        PPC_SETTINGS_rychkova_d_sobel_edge_detection);
+
+const auto kModePerfTasks = std::tuple_cat(
+    MakePerfTaskTuplesWithOptions<SobelEdgeDetectionMPI>(PPC_SETTINGS_rychkova_d_sobel_edge_detection, kSeparable,
+                                                         "separable"),
+    MakePerfTaskTuplesWithOptions<SobelEdgeDetectionSEQ>(PPC_SETTINGS_rychkova_d_sobel_edge_detection, kSeparable,
+                                                         "separable"),
+    MakePerfTaskTuplesWithOptions<SobelEdgeDetectionMPI>(PPC_SETTINGS_rychkova_d_sobel_edge_detection, kFused,
+                                                         "fused"),
+    MakePerfTaskTuplesWithOptions<SobelEdgeDetectionSEQ>(PPC_SETTINGS_rychkova_d_sobel_edge_detection, kFused,
+                                                         "fused"),
+    MakePerfTaskTuplesWithOptions<SobelEdgeDetectionMPI>(PPC_SETTINGS_rychkova_d_sobel_edge_detection, kExchange,
+                                                         "exchange"),
+    MakePerfTaskTuplesWithOptions<SobelEdgeDetectionMPI>(PPC_SETTINGS_rychkova_d_sobel_edge_detection, kOverlap,
+                                                         "overlap"),
+    MakePerfTaskTuplesWithOptions<SobelEdgeDetectionMPI>(PPC_SETTINGS_rychkova_d_sobel_edge_detection, kBlocks,
+                                                         "blocks"),
+    MakePerfTaskTuplesWithOptions<SobelEdgeDetectionMPI>(PPC_SETTINGS_rychkova_d_sobel_edge_detection, kShared,
+                                                         "shared"),
+    MakePerfTaskTuplesWithOptions<SobelEdgeDetectionMPI>(PPC_SETTINGS_rychkova_d_sobel_edge_detection, kDistributed,
+                                                         "distributed"),
+    MakePerfTaskTuplesWithOptions<SobelEdgeDetectionALL>(PPC_SETTINGS_rychkova_d_sobel_edge_detection, kTiled,
+                                                         "tiled"),
+    MakePerfTaskTuplesWithOptions<SobelEdgeDetectionMPI>(PPC_SETTINGS_rychkova_d_sobel_edge_detection, kTiled,
+                                                         "tiled"),
+    MakePerfTaskTuplesWithOptions<SobelEdgeDetectionOMP>(PPC_SETTINGS_rychkova_d_sobel_edge_detection, kTiled,
+                                                         "tiled"),
+    MakePerfTaskTuplesWithOptions<SobelEdgeDetectionSEQ>(PPC_SETTINGS_rychkova_d_sobel_edge_detection, kTiled,
+                                                         "tiled"),
+    MakePerfTaskTuplesWithOptions<SobelEdgeDetectionSTL>(PPC_SETTINGS_rychkova_d_sobel_edge_detection, kTiled,
+                                                         "tiled"),
+    MakePerfTaskTuplesWithOptions<SobelEdgeDetectionTBB>(PPC_SETTINGS_rychkova_d_sobel_edge_detection, kTiled,
+                                                         "tiled"));
+
+const auto kGtestValues = ppc::util::TupleToGTestValues(std::tuple_cat(kAllPerfTasks, kModePerfTasks));
 
 const auto kPerfTestName = RychkovaDRunPerfTestsSobel::CustomPerfTestName;
 
 INSTANTIATE_TEST_SUITE_P(RunModeTests, RychkovaDRunPerfTestsSobel, kGtestValues, kPerfTestName);
 
+/// @brief A clip of RGB video frames for the stream tasks; throughput is frames / measured time.
+class RychkovaDRunStreamPerfTestsSobel : public ppc::util::BaseRunPerfTests<FrameStream, FrameStream> {
+  static constexpr std::size_t kFrames_ = 48;
+  static constexpr std::size_t kW_ = 640;
+  static constexpr std::size_t kH_ = 480;
+
+  FrameStream frames_;
+
+ protected:
+  void SetUp() override {
+    frames_.resize(kFrames_);
+    for (std::size_t f = 0; f < kFrames_; ++f) {
+      Image &frame = frames_[f];
+      frame.width = kW_;
+      frame.height = kH_;
+      frame.channels = 3;
+      frame.data.resize(kW_ * kH_ * 3);
+      for (std::size_t i = 0; i < frame.data.size(); ++i) {
+        frame.data[i] = static_cast<std::uint8_t>(((i + f) * 37 + 13) % 256);
+      }
+    }
+  }
+
+  bool CheckTestOutputData(FrameStream &output_data) final {
+    if (output_data.size() != kFrames_) {
+      return false;
+    }
+    return std::ranges::all_of(output_data, [](const Image &frame) {
+      return frame.width == kW_ && frame.height == kH_ && frame.channels == 1 && frame.data.size() == kW_ * kH_;
+    });
+  }
+
+  FrameStream GetTestInputData() final {
+    return frames_;
+  }
+};
+
+TEST_P(RychkovaDRunStreamPerfTestsSobel, RunPerfModes) {
+  ExecuteTest(GetParam());
+}
+
+// stream_serial keeps a single frame in flight, the baseline the pipelined stream is measured against.
+const auto kStreamPerfTasks = std::tuple_cat(
+    MakePerfTaskTuplesWithOptions<SobelStreamTBB, FrameStream, FrameStream>(
+        PPC_SETTINGS_rychkova_d_sobel_edge_detection, {}, "stream"),
+    MakePerfTaskTuplesWithOptions<SobelStreamTBB, FrameStream, FrameStream>(
+        PPC_SETTINGS_rychkova_d_sobel_edge_detection, SobelOptions{.stream_depth = 1}, "stream_serial"));
+
+INSTANTIATE_TEST_SUITE_P(RunStreamTests, RychkovaDRunStreamPerfTestsSobel,
+                         ppc::util::TupleToGTestValues(kStreamPerfTasks),
+                         RychkovaDRunStreamPerfTestsSobel::CustomPerfTestName);
+
+/// @brief The 1024x1024 gray frame of RychkovaDRunPerfTestsSobel as 12-bit u16 or float samples, filtered at full
+///        precision by the typed sequential task.
+template <typename Pixel>
+class RychkovaDRunPixelPerfTestsSobel : public ppc::util::BaseRunPerfTests<BasicImage<Pixel>, BasicImage<Pixel>> {
+  static constexpr std::size_t kW_ = 1024;
+  static constexpr std::size_t kH_ = 1024;
+
+  BasicImage<Pixel> input_data_{};
+
+ protected:
+  void SetUp() override {
+    input_data_.width = kW_;
+    input_data_.height = kH_;
+    input_data_.data.resize(kW_ * kH_);
+    for (std::size_t i = 0; i < input_data_.data.size(); ++i) {
+      input_data_.data[i] = static_cast<Pixel>((i * 37 + 13) % 4096);
+    }
+  }
+
+  bool CheckTestOutputData(BasicImage<Pixel> &output_data) final {
+    return output_data.width == kW_ && output_data.height == kH_ && output_data.channels == 1 &&
+           output_data.data.size() == kW_ * kH_;
+  }
+
+  BasicImage<Pixel> GetTestInputData() final {
+    return input_data_;
+  }
+};
+
+using RychkovaDRunU16PerfTestsSobel = RychkovaDRunPixelPerfTestsSobel<uint16_t>;
+using RychkovaDRunF32PerfTestsSobel = RychkovaDRunPixelPerfTestsSobel<float>;
+
+TEST_P(RychkovaDRunU16PerfTestsSobel, RunPerfModes) {
+  ExecuteTest(GetParam());
+}
+
+TEST_P(RychkovaDRunF32PerfTestsSobel, RunPerfModes) {
+  ExecuteTest(GetParam());
+}
+
+const auto kU16PerfTasks = MakePerfTaskTuplesWithOptions<BasicSobelEdgeDetectionSEQ<uint16_t>, Image16, Image16>(
+    PPC_SETTINGS_rychkova_d_sobel_edge_detection, {}, "u16");
+const auto kF32PerfTasks = MakePerfTaskTuplesWithOptions<BasicSobelEdgeDetectionSEQ<float>, ImageF32, ImageF32>(
+    PPC_SETTINGS_rychkova_d_sobel_edge_detection, {}, "f32");
+
+INSTANTIATE_TEST_SUITE_P(RunU16Tests, RychkovaDRunU16PerfTestsSobel, ppc::util::TupleToGTestValues(kU16PerfTasks),
+                         RychkovaDRunU16PerfTestsSobel::CustomPerfTestName);
+INSTANTIATE_TEST_SUITE_P(RunF32Tests, RychkovaDRunF32PerfTestsSobel, ppc::util::TupleToGTestValues(kF32PerfTasks),
+                         RychkovaDRunF32PerfTestsSobel::CustomPerfTestName);
+
+/// @brief A 1024x1024 gray region of interest inside a padded 1056x1040 canvas, read in place by the tasks.
+class RychkovaDRunRoiPerfTestsSobel : public ppc::util::BaseRunPerfTests<InType, OutType> {
+  static constexpr std::size_t kW_ = 1024;
+  static constexpr std::size_t kH_ = 1024;
+  static constexpr std::size_t kMargin_ = 16;
+
+  InType canvas_{};
+
+ protected:
+  void SetUp() override {
+    canvas_ = MakePaddedImage<uint8_t>(kW_ + (2 * kMargin_), kH_ + kMargin_);
+    for (std::size_t i = 0; i < canvas_.data.size(); ++i) {
+      canvas_.data[i] = static_cast<std::uint8_t>((i * 37 + 13) % 256);
+    }
+  }
+
+  bool CheckTestOutputData(OutType &output_data) final {
+    return output_data.width == kW_ && output_data.height == kH_ && output_data.data.size() == kW_ * kH_;
+  }
+
+  InType GetTestInputData() final {
+    InType canvas = canvas_;
+    return Roi(std::move(canvas), kMargin_, kMargin_ / 2, kW_, kH_);
+  }
+};
+
+TEST_P(RychkovaDRunRoiPerfTestsSobel, RunPerfModes) {
+  ExecuteTest(GetParam());
+}
+
+// roi_fused filters the region straight from the canvas rows; roi repacks it into the gray frame first.
+const auto kRoiPerfTasks =
+    std::tuple_cat(MakePerfTaskTuplesWithOptions<SobelEdgeDetectionSEQ>(PPC_SETTINGS_rychkova_d_sobel_edge_detection,
+                                                                        {}, "roi"),
+                   MakePerfTaskTuplesWithOptions<SobelEdgeDetectionSEQ>(PPC_SETTINGS_rychkova_d_sobel_edge_detection,
+                                                                        kFused, "roi_fused"));
+
+INSTANTIATE_TEST_SUITE_P(RunRoiTests, RychkovaDRunRoiPerfTestsSobel, ppc::util::TupleToGTestValues(kRoiPerfTasks),
+                         RychkovaDRunRoiPerfTestsSobel::CustomPerfTestName);
+
+/// @brief Many RGB thumbnails packed into one batch; one pipeline invocation processes all of them.
+class RychkovaDRunBatchPerfTestsSobel : public ppc::util::BaseRunPerfTests<ImageBatch, ImageBatch> {
+  static constexpr std::size_t kImages_ = 2048;
+  static constexpr std::size_t kSide_ = 64;
+
+  ImageBatch batch_;
+
+ protected:
+  void SetUp() override {
+    constexpr std::size_t kBytes = kSide_ * kSide_ * 3;
+    batch_.entries.resize(kImages_);
+    batch_.data.resize(kImages_ * kBytes);
+    for (std::size_t k = 0; k < kImages_; ++k) {
+      batch_.entries[k] = BatchEntry{.offset = k * kBytes, .width = kSide_, .height = kSide_, .channels = 3};
+    }
+    for (std::size_t i = 0; i < batch_.data.size(); ++i) {
+      batch_.data[i] = static_cast<std::uint8_t>((i * 37 + 13) % 256);
+    }
+  }
+
+  bool CheckTestOutputData(ImageBatch &output_data) final {
+    if (output_data.entries.size() != kImages_ || output_data.data.size() != kImages_ * kSide_ * kSide_) {
+      return false;
+    }
+    return std::ranges::all_of(output_data.entries, [](const BatchEntry &entry) {
+      return entry.width == kSide_ && entry.height == kSide_ && entry.channels == 1;
+    });
+  }
+
+  ImageBatch GetTestInputData() final {
+    return batch_;
+  }
+};
+
+TEST_P(RychkovaDRunBatchPerfTestsSobel, RunPerfModes) {
+  ExecuteTest(GetParam());
+}
+
+const auto kBatchPerfTasks = MakePerfTaskTuplesWithOptions<SobelBatchOMP, ImageBatch, ImageBatch>(
+    PPC_SETTINGS_rychkova_d_sobel_edge_detection, {}, "batch");
+
+INSTANTIATE_TEST_SUITE_P(RunBatchTests, RychkovaDRunBatchPerfTestsSobel, ppc::util::TupleToGTestValues(kBatchPerfTasks),
+                         RychkovaDRunBatchPerfTestsSobel::CustomPerfTestName);
+
+/// @brief An RGB PPM on disk streamed through the out-of-core task; the file is written into the per-test temporary
+///        directory, so every rank of an MPI run has its own copy.
+class RychkovaDRunFilePerfTestsSobel : public ppc::util::BaseRunPerfTests<ImageFileJob, ImageFile> {
+  static constexpr std::size_t kW_ = 4096;
+  static constexpr std::size_t kH_ = 1024;
+
+ protected:
+  bool CheckTestOutputData(ImageFile &output_data) final {
+    return output_data.width == kW_ && output_data.height == kH_ && output_data.channels == 1;
+  }
+
+  ImageFileJob GetTestInputData() final {
+    const std::filesystem::path dir = env::get<std::string>("PPC_TEST_TMPDIR").value();
+    const std::filesystem::path input = dir / "perf_in.ppm";
+    std::ofstream out(input, std::ios::binary);
+    out << "P6\n" << kW_ << ' ' << kH_ << "\n255\n";
+    std::vector<char> row(kW_ * 3);
+    for (std::size_t y = 0; y < kH_; ++y) {
+      for (std::size_t i = 0; i < row.size(); ++i) {
+        row[i] = static_cast<char>((((y * row.size()) + i) * 37 + 13) % 256);
+      }
+      out.write(row.data(), static_cast<std::streamsize>(row.size()));
+    }
+    return ImageFileJob{.input = ImageFile{.path = input.string()}, .output_path = (dir / "perf_out.pgm").string()};
+  }
+};
+
+TEST_P(RychkovaDRunFilePerfTestsSobel, RunPerfModes) {
+  ExecuteTest(GetParam());
+}
+
+const auto kFilePerfTasks = MakePerfTaskTuplesWithOptions<SobelFileSEQ, ImageFileJob, ImageFile>(
+    PPC_SETTINGS_rychkova_d_sobel_edge_detection, {}, "file");
+
+INSTANTIATE_TEST_SUITE_P(RunFileTests, RychkovaDRunFilePerfTestsSobel, ppc::util::TupleToGTestValues(kFilePerfTasks),
+                         RychkovaDRunFilePerfTestsSobel::CustomPerfTestName);
+
+namespace {
+
+/// @brief Side of the large RGB perf frame from PPC_SOBEL_LARGE_SIDE; sides from 26755 up exceed 2 GiB, the range
+///        where byte counts no longer fit the int counts of MPI. Zero (the case is not instantiated) when unset,
+///        since such a frame needs several GiB of memory per node.
+std::size_t LargeSide() {
+  const int side = env::get<int>("PPC_SOBEL_LARGE_SIDE").value_or(0);
+  return side >= 3 ? static_cast<std::size_t>(side) : 0;
+}
+
+}  // namespace
+
+class RychkovaDRunLargePerfTestsSobel : public ppc::util::BaseRunPerfTests<InType, OutType> {
+  std::size_t side_ = LargeSide();
+
+ protected:
+  bool CheckTestOutputData(OutType &output_data) final {
+    int rank = 0;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if (rank != 0) {
+      return true;
+    }
+    return output_data.width == side_ && output_data.height == side_ && output_data.data.size() == side_ * side_;
+  }
+
+  InType GetTestInputData() final {
+    // Built on demand instead of kept in the fixture: the task owns the only copy of the frame.
+    InType input;
+    input.width = side_;
+    input.height = side_;
+    input.channels = 3;
+    input.data.resize(side_ * side_ * 3);
+    for (std::size_t i = 0; i < input.data.size(); ++i) {
+      input.data[i] = static_cast<std::uint8_t>((i * 37 + 13) % 256);
+    }
+    return input;
+  }
+};
+
+TEST_P(RychkovaDRunLargePerfTestsSobel, RunPerfModes) {
+  ExecuteTest(GetParam());
+}
+
+namespace {
+
+std::vector<ppc::util::PerfTestParam<InType, OutType>> LargePerfParams() {
+  if (LargeSide() == 0) {
+    return {};
+  }
+  const auto tasks =
+      MakePerfTaskTuplesWithOptions<SobelEdgeDetectionMPI>(PPC_SETTINGS_rychkova_d_sobel_edge_detection, {}, "large");
+  return {std::get<0>(tasks), std::get<1>(tasks)};
+}
+
+}  // namespace
+
+GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(RychkovaDRunLargePerfTestsSobel);
+
+INSTANTIATE_TEST_SUITE_P(RunLargeTests, RychkovaDRunLargePerfTestsSobel, ::testing::ValuesIn(LargePerfParams()),
+                         RychkovaDRunLargePerfTestsSobel::CustomPerfTestName);
+
 }  // namespace rychkova_d_sobel_edge_detection